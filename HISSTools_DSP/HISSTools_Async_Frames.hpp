@@ -0,0 +1,142 @@
+
+#ifndef __HISSTOOLS_ASYNC_FRAMES__
+#define __HISSTOOLS_ASYNC_FRAMES__
+
+#include <atomic>
+#include <functional>
+#include "HISSTools_SIMD.hpp"
+#include "../HISSTools_Utility/HISSTools_ThreadSafety.hpp"
+
+
+// A fixed set of frame slots that are filled on the audio thread and processed in order on a worker thread
+// Nothing on the audio thread blocks or allocates - if no slot is free the caller drops the frame (and counts an overrun)
+
+// Slots are either collected by the audio thread when done (release()) or abandoned to be reused once the worker is finished
+
+template <class T>
+class HISSTools_Async_Frames
+{
+
+public:
+
+	struct Slot
+	{
+		T *mFrames[256];
+		unsigned long mFrameSize;
+		unsigned long mNChans;
+		double mFractionalOffset;
+		bool mMultichannel;
+	};
+
+	typedef std::function<void(Slot&)> Processor;
+
+	HISSTools_Async_Frames(unsigned long maxFrameSize, unsigned long maxChans, unsigned long nSlots, Processor processor)
+	: mProcessor(processor), mNSlots(nSlots < 1 ? 1 : nSlots), mQueue(mNSlots)
+	{
+		unsigned long bufferStride = HISSTools_SIMD::alignedSize(maxFrameSize, sizeof(T));
+
+		mSlots = new Slot[mNSlots];
+		mStates = new std::atomic<int>[mNSlots];
+		mAbandoned = new bool[mNSlots];
+		mSlab = HISSTools_SIMD::allocate<T>(bufferStride * maxChans * mNSlots);
+
+		for (unsigned long i = 0; i < mNSlots; i++)
+		{
+			for (unsigned long j = 0; mSlab && j < maxChans; j++)
+				mSlots[i].mFrames[j] = mSlab + (((i * maxChans) + j) * bufferStride);
+
+			mStates[i] = mSlab ? kFree : kQueued;
+			mAbandoned[i] = false;
+		}
+
+		mWorker = new HISSTools_WorkerThread(std::bind(&HISSTools_Async_Frames::work, this));
+	}
+
+	~HISSTools_Async_Frames()
+	{
+		// Stop the worker before freeing anything it might be using
+
+		delete mWorker;
+
+		HISSTools_SIMD::deallocate(mSlab);
+		delete[] mAbandoned;
+		delete[] mStates;
+		delete[] mSlots;
+	}
+
+	// Non-copyable
+
+	HISSTools_Async_Frames(const HISSTools_Async_Frames&) = delete;
+	HISSTools_Async_Frames& operator=(const HISSTools_Async_Frames&) = delete;
+
+	// Audio thread only (returns -1 if no slot is free)
+
+	long acquire()
+	{
+		for (unsigned long i = 0; i < mNSlots; i++)
+		{
+			int state = mStates[i].load(std::memory_order_acquire);
+
+			if (state == kFree)
+				return i;
+
+			if (mAbandoned[i] && state == kDone)
+			{
+				mAbandoned[i] = false;
+				return i;
+			}
+		}
+
+		return -1;
+	}
+
+	Slot& getSlot(long slot)	{ return mSlots[slot]; }
+
+	void submit(long slot)
+	{
+		mStates[slot].store(kQueued, std::memory_order_release);
+		mQueue.push(slot);
+		mWorker->wake();
+	}
+
+	bool isDone(long slot)		{ return mStates[slot].load(std::memory_order_acquire) == kDone; }
+	void release(long slot)		{ mStates[slot].store(kFree, std::memory_order_relaxed); }
+	void abandon(long slot)		{ mAbandoned[slot] = true; }
+
+private:
+
+	enum SlotState {kFree, kQueued, kDone};
+
+	// Worker thread
+
+	void work()
+	{
+		long slot;
+
+		while (mQueue.pop(slot))
+		{
+			mProcessor(mSlots[slot]);
+			mStates[slot].store(kDone, std::memory_order_release);
+		}
+	}
+
+	// Processing
+
+	Processor mProcessor;
+
+	// Slots
+
+	unsigned long mNSlots;
+	Slot *mSlots;
+	std::atomic<int> *mStates;
+	bool *mAbandoned;
+	T *mSlab;
+
+	// Queue and Worker
+
+	HISSTools_SPSCQueue<long> mQueue;
+	HISSTools_WorkerThread *mWorker;
+};
+
+
+#endif
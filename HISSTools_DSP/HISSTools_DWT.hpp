@@ -3,6 +3,10 @@
 #ifndef __HISSTOOLS_DWT__
 #define __HISSTOOLS_DWT__
 
+#include <math.h>
+#include <algorithm>
+#include "HISSTools_SIMD.hpp"
+
 
 class HISSTools_Wavelet
 {
@@ -85,8 +89,13 @@ public:
 		unsigned long i;
 		double flip;
 		
-		delete[] mInverseLoPass;
-		delete[] mInverseHiPass;
+		// Only delete the inverse filters if they are not shared with the forward filters
+		
+		if (mInverseIndependent == TRUE)
+		{
+			delete[] mInverseLoPass;
+			delete[] mInverseHiPass;
+		}
 		
 		mInverseLoPass = new double[length];
 		mInverseHiPass = new double[length];
@@ -122,6 +131,27 @@ public:
 		mInverseIndependent = false;
 	}
 	
+	
+	// Biorthogonal wavelets (the lowpass filters should be the same length, and are stored in the same order as above)
+	// Each highpass filter is derived from the opposite lowpass filter, so that the pair reconstructs perfectly
+	
+	virtual void setBiorthogonalFilters(const double *forwardLoPass, const double *inverseLoPass, unsigned long length, long offset = 0)
+	{
+		unsigned long i;
+		double flip;
+		
+		setForwardFilters(forwardLoPass, length, offset);
+		setInverseFilters(inverseLoPass, length, offset);
+		
+		length = std::min(mForwardLength, mInverseLength);
+		
+		for (i = 0, flip = 1; i < length; i++, flip *= -1)
+		{
+			mForwardHiPass[i] = mInverseLoPass[length - i - 1] * flip;
+			mInverseHiPass[i] = mForwardLoPass[length - i - 1] * flip;
+		}
+	}
+	
 		
 	// FIR Filters
 	
@@ -142,11 +172,400 @@ public:
 };
 
 
+// A precomputed plan for repeated transforms of a given wavelet, length and number of levels
+
+// The filter taps are copied into a single aligned block, and offsets are wrapped for each level in advance
+// Periodic wrapping is done by copying each band (with its wrapped samples) into scratch memory, so the filter loops never wrap
+// Transforms using a plan do no setup work and never allocate, but a plan should only be used by one thread at a time
+
+class HISSTools_DWT_Plan
+{
+
+public:
+
+	HISSTools_DWT_Plan(const HISSTools_Wavelet *wavelet, unsigned long length, unsigned long levels)
+	: mLength(length), mLevels(levels)
+	{
+		unsigned long forwardStride = HISSTools_SIMD::alignedSize(wavelet->mForwardLength, sizeof(double));
+		unsigned long inverseStride = HISSTools_SIMD::alignedSize(wavelet->mInverseLength, sizeof(double));
+		unsigned long maxTaps = std::max(wavelet->mForwardLength, wavelet->mInverseLength);
+		unsigned long maxSpan = levels ? (maxTaps ? maxTaps - 1 : 0) << (levels - 1) : 0;
+		
+		// Taps
+		
+		mTaps = HISSTools_SIMD::allocate<double>(2 * (forwardStride + inverseStride));
+		
+		mForwardLoPass = mTaps;
+		mForwardHiPass = mForwardLoPass + forwardStride;
+		mInverseLoPass = mForwardHiPass + forwardStride;
+		mInverseHiPass = mInverseLoPass + inverseStride;
+		
+		mForwardLength = wavelet->mForwardLength;
+		mInverseLength = wavelet->mInverseLength;
+		mForwardOffset = (long) wavelet->mForwardOffset;
+		mInverseOffset = (long) wavelet->mInverseOffset;
+		
+		for (unsigned long i = 0; i < mForwardLength; i++)
+		{
+			mForwardLoPass[i] = wavelet->mForwardLoPass[i];
+			mForwardHiPass[i] = wavelet->mForwardHiPass[i];
+		}
+		
+		for (unsigned long i = 0; i < mInverseLength; i++)
+		{
+			mInverseLoPass[i] = wavelet->mInverseLoPass[i];
+			mInverseHiPass[i] = wavelet->mInverseHiPass[i];
+		}
+		
+		// Offsets wrapped to the length of each level (and for the a trous transform scaled by the level spacing)
+		
+		mLevelOffsets = new long[(levels + 1) * 4];
+		
+		for (unsigned long i = 0; i < levels + 1; i++)
+		{
+			unsigned long levelLength = length >> i;
+			
+			mLevelOffsets[i * 4 + 0] = wrap(mForwardOffset, levelLength);
+			mLevelOffsets[i * 4 + 1] = wrap(mInverseOffset, levelLength);
+			mLevelOffsets[i * 4 + 2] = wrap(mForwardOffset * (long) (1UL << i), length);
+			mLevelOffsets[i * 4 + 3] = wrap(mInverseOffset * (long) (1UL << i), length);
+		}
+		
+		// Scratch (two bands extended by the widest a trous filter span)
+		
+		mScratchSize = length + maxSpan + maxTaps;
+		mScratch = HISSTools_SIMD::allocate<double>(mScratchSize * 2);
+	}
+	
+	
+	~HISSTools_DWT_Plan()
+	{
+		HISSTools_SIMD::deallocate(mTaps);
+		HISSTools_SIMD::deallocate(mScratch);
+		delete[] mLevelOffsets;
+	}
+	
+	
+	// Non-copyable
+	
+	HISSTools_DWT_Plan(const HISSTools_DWT_Plan&) = delete;
+	HISSTools_DWT_Plan& operator=(const HISSTools_DWT_Plan&) = delete;
+	
+	
+	// The plan matches if the wavelet filters (which are compared by value), length and levels are the same
+	
+	bool matches(const HISSTools_Wavelet *wavelet, unsigned long length, unsigned long levels) const
+	{
+		if (length != mLength || levels != mLevels || wavelet->mForwardLength != mForwardLength || wavelet->mInverseLength != mInverseLength)
+			return FALSE;
+		
+		if ((long) wavelet->mForwardOffset != mForwardOffset || (long) wavelet->mInverseOffset != mInverseOffset)
+			return FALSE;
+		
+		for (unsigned long i = 0; i < mForwardLength; i++)
+			if (wavelet->mForwardLoPass[i] != mForwardLoPass[i] || wavelet->mForwardHiPass[i] != mForwardHiPass[i])
+				return FALSE;
+		
+		for (unsigned long i = 0; i < mInverseLength; i++)
+			if (wavelet->mInverseLoPass[i] != mInverseLoPass[i] || wavelet->mInverseHiPass[i] != mInverseHiPass[i])
+				return FALSE;
+		
+		return TRUE;
+	}
+	
+	
+	// Plans are only valid if the length is divisible by 2 ^ levels (transforms with an invalid plan return FALSE)
+	
+	bool isValid() const
+	{
+		return mTaps && mScratch && mLevels < (sizeof(unsigned long) * 8) && mLength && !(mLength & ((1UL << mLevels) - 1));
+	}
+	
+	unsigned long getLength() const		{ return mLength; }
+	unsigned long getLevels() const		{ return mLevels; }
+	
+	
+	// Dyadic (Mallat) transform - the layout is the same as HISSTools_DWT (approximation, then details from coarsest to finest)
+	
+	bool forwardDWT(const double *in, double *out)
+	{
+		if (!isValid())
+			return FALSE;
+		
+		if (!mLevels)
+		{
+			if (in != out)
+				HISSTools_SIMD::copy(out, in, mLength);
+			return TRUE;
+		}
+		
+		for (unsigned long i = 0, length = mLength; i < mLevels; i++, length >>= 1)
+			analyse(i ? out : in, out, out + (length >> 1), length, mLevelOffsets[i * 4]);
+		
+		return TRUE;
+	}
+	
+	
+	bool inverseDWT(const double *in, double *out)
+	{
+		if (!isValid())
+			return FALSE;
+		
+		if (!mLevels)
+		{
+			if (in != out)
+				HISSTools_SIMD::copy(out, in, mLength);
+			return TRUE;
+		}
+		
+		for (unsigned long i = mLevels, length = mLength >> (mLevels - 1); i--; length <<= 1)
+			synthesise(i + 1 == mLevels ? in : out, in + (length >> 1), out, length, mLevelOffsets[i * 4 + 1]);
+		
+		return TRUE;
+	}
+	
+	
+	// Wavelet packet transform - every band is split at every level (bands are in natural rather than frequency order)
+	
+	bool forwardPacket(const double *in, double *out)
+	{
+		if (!isValid())
+			return FALSE;
+		
+		if (!mLevels)
+		{
+			if (in != out)
+				HISSTools_SIMD::copy(out, in, mLength);
+			return TRUE;
+		}
+		
+		for (unsigned long i = 0, length = mLength; i < mLevels; i++, length >>= 1)
+			for (unsigned long j = 0; j < mLength; j += length)
+				analyse((i ? out : in) + j, out + j, out + j + (length >> 1), length, mLevelOffsets[i * 4]);
+		
+		return TRUE;
+	}
+	
+	
+	bool inversePacket(const double *in, double *out)
+	{
+		if (!isValid())
+			return FALSE;
+		
+		if (!mLevels)
+		{
+			if (in != out)
+				HISSTools_SIMD::copy(out, in, mLength);
+			return TRUE;
+		}
+		
+		for (unsigned long i = mLevels, length = mLength >> (mLevels - 1); i--; length <<= 1)
+		{
+			const double *source = i + 1 == mLevels ? in : out;
+			
+			for (unsigned long j = 0; j < mLength; j += length)
+				synthesise(source + j, source + j + (length >> 1), out + j, length, mLevelOffsets[i * 4 + 1]);
+		}
+		
+		return TRUE;
+	}
+	
+	
+	// Undecimated (a trous) transform - the coefficients are levels + 1 arrays of length samples
+	// These are the details from finest to coarsest, followed by the approximation (the inverse averages both polyphases)
+	
+	bool forwardATrous(const double *in, double *coefficients)
+	{
+		if (!isValid())
+			return FALSE;
+		
+		double *approx = coefficients + mLevels * mLength;
+		
+		if (!mLevels)
+		{
+			if (in != approx)
+				HISSTools_SIMD::copy(approx, in, mLength);
+			return TRUE;
+		}
+		
+		for (unsigned long i = 0; i < mLevels; i++)
+		{
+			unsigned long spacing = 1UL << i;
+			double *extended = mScratch;
+			double *details = coefficients + i * mLength;
+			
+			extend(extended, i ? approx : in, mLength, mLevelOffsets[i * 4 + 2], mLength + (mForwardLength - 1) * spacing);
+			
+			zero(details, mLength);
+			zero(approx, mLength);
+			
+			for (unsigned long j = 0; j < mForwardLength; j += 2)
+			{
+				const double *in1 = extended + j * spacing;
+				const double *in2 = j + 1 < mForwardLength ? in1 + spacing : in1;
+				
+				HISSTools_SIMD::lift(details, in1, in2, mForwardHiPass[j], j + 1 < mForwardLength ? mForwardHiPass[j + 1] : 0.0, mLength);
+				HISSTools_SIMD::lift(approx, in1, in2, mForwardLoPass[j], j + 1 < mForwardLength ? mForwardLoPass[j + 1] : 0.0, mLength);
+			}
+		}
+		
+		return TRUE;
+	}
+	
+	
+	bool inverseATrous(const double *coefficients, double *out)
+	{
+		if (!isValid())
+			return FALSE;
+		
+		const double *approx = coefficients + mLevels * mLength;
+		
+		if (!mLevels)
+		{
+			if (approx != out)
+				HISSTools_SIMD::copy(out, approx, mLength);
+			return TRUE;
+		}
+		
+		for (unsigned long i = mLevels; i--; )
+		{
+			unsigned long spacing = 1UL << i;
+			unsigned long span = (mInverseLength - 1) * spacing;
+			double *extendedLo = mScratch;
+			double *extendedHi = mScratch + mScratchSize;
+			
+			// The filters are applied in reverse from the end of the extended bands (as the transpose of the forward transform)
+			
+			extend(extendedLo, i + 1 == mLevels ? approx : out, mLength, wrap(-(mLevelOffsets[i * 4 + 3] + (long) span), mLength), mLength + span);
+			extend(extendedHi, coefficients + i * mLength, mLength, wrap(-(mLevelOffsets[i * 4 + 3] + (long) span), mLength), mLength + span);
+			
+			zero(out, mLength);
+			
+			for (unsigned long j = 0; j < mInverseLength; j++)
+			{
+				unsigned long position = span - j * spacing;
+				
+				HISSTools_SIMD::lift(out, extendedLo + position, extendedHi + position, mInverseLoPass[j] * 0.5, mInverseHiPass[j] * 0.5, mLength);
+			}
+		}
+		
+		return TRUE;
+	}
+
+
+private:
+
+	static long wrap(long offset, unsigned long length)
+	{
+		long wrapped = offset % (long) length;
+		
+		return wrapped < 0 ? wrapped + (long) length : wrapped;
+	}
+	
+	static void zero(double *io, unsigned long length)
+	{
+		for (unsigned long i = 0; i < length; i++)
+			io[i] = 0.0;
+	}
+	
+	// Copy a band periodically from a given (wrapped) start position
+	
+	static void extend(double *extended, const double *in, unsigned long length, long start, unsigned long extendedLength)
+	{
+		for (unsigned long i = 0, j = start, loopSize; i < extendedLength; i += loopSize, j = 0)
+		{
+			loopSize = std::min(length - j, extendedLength - i);
+			HISSTools_SIMD::copy(extended + i, in + j, loopSize);
+		}
+	}
+	
+	// Single level decimated transforms (the outputs may be the same as the inputs)
+	
+	void analyse(const double *in, double *lo, double *hi, unsigned long length, long offset)
+	{
+		double *extended = mScratch;
+		
+		extend(extended, in, length, offset, length + mForwardLength - 1);
+		
+		for (unsigned long i = 0; i < (length >> 1); i++)
+		{
+			const double *samples = extended + (i << 1);
+			double loSum = 0.0;
+			double hiSum = 0.0;
+			
+			for (unsigned long j = 0; j < mForwardLength; j++)
+			{
+				loSum += mForwardLoPass[j] * samples[j];
+				hiSum += mForwardHiPass[j] * samples[j];
+			}
+			
+			lo[i] = loSum;
+			hi[i] = hiSum;
+		}
+	}
+	
+	void synthesise(const double *lo, const double *hi, double *out, unsigned long length, long offset)
+	{
+		double *accumulated = mScratch;
+		unsigned long accumulatedLength = length + mInverseLength - 1;
+		
+		zero(accumulated, accumulatedLength);
+		
+		for (unsigned long i = 0; i < (length >> 1); i++)
+		{
+			double *samples = accumulated + (i << 1);
+			double loVal = lo[i];
+			double hiVal = hi[i];
+			
+			for (unsigned long j = 0; j < mInverseLength; j++)
+				samples[j] += (mInverseLoPass[j] * loVal) + (mInverseHiPass[j] * hiVal);
+		}
+		
+		// Fold the accumulated samples back into the band from the offset
+		
+		for (unsigned long i = 0, j = offset; i < length; i++, j = j + 1 == length ? 0 : j + 1)
+			out[j] = accumulated[i];
+		
+		for (unsigned long i = length, j = offset; i < accumulatedLength; i++, j = j + 1 == length ? 0 : j + 1)
+			out[j] += accumulated[i];
+	}
+	
+	// Taps
+	
+	double *mTaps;
+	double *mForwardLoPass;
+	double *mForwardHiPass;
+	double *mInverseLoPass;
+	double *mInverseHiPass;
+	
+	unsigned long mForwardLength;
+	unsigned long mInverseLength;
+	long mForwardOffset;
+	long mInverseOffset;
+	
+	// Levels (forward / inverse offsets for the decimated and a trous transforms at each level)
+	
+	unsigned long mLength;
+	unsigned long mLevels;
+	long *mLevelOffsets;
+	
+	// Scratch
+	
+	double *mScratch;
+	unsigned long mScratchSize;
+};
+
+
 class HISSTools_DWT
 {
 	
 public:
 	
+	// Standard wavelets for the lifting engine (periodic boundaries - Haar and D4 are orthonormal, CDF 9/7 has a DC gain of sqrt(2))
+	// Haar coefficients match the filter-based Haar (HISSTools_Wavelet_Library::kHaar) including the sign of the details
+	
+	enum LiftingWavelet {kLiftingHaar, kLiftingD4, kLiftingCDF97};
+	
 	HISSTools_DWT(unsigned long maxLength)
 	{
 		mTemp = new double[maxLength];
@@ -331,6 +750,214 @@ public:
 	}	
 	
 	
+	// Lifting engine (output is in the same layout as above - approximation first, then details from coarsest to finest)
+	
+	// Each level splits the signal into even (s) and odd (d) samples and applies the lifting steps to the two halves
+	// Steps are vectorised with the periodic wrap handled outside of the loop, and the halves are written in place in the output
+	// Only the final approximation is copied, and the inverse fuses its scaling with the gathering of each level
+	
+	bool forwardDWT (double *in, double *out, unsigned long length, unsigned long levels, LiftingWavelet wavelet)
+	{
+		const LiftingScheme &scheme = getLiftingScheme(wavelet);
+		
+		double *s = mTemp;
+		unsigned long i, j, half;
+		
+		// Sanity Check
+		
+		if (length > mMaxLength || !validLength(length, levels))
+			return FALSE;
+		
+		if (!levels)
+		{
+			if (in != out)
+				HISSTools_SIMD::copy(out, in, length);
+			return TRUE;
+		}
+		
+		for (i = 0; i < levels; i++, length >>= 1)
+		{
+			double *d = out + (length >> 1);
+			half = length >> 1;
+			
+			// Split (the first level counts down so the details can be written over the input when in == out)
+			
+			if (i)
+			{
+				for (j = 0; j < half; j++)
+				{
+					s[j] = s[(j << 1)];
+					d[j] = s[(j << 1) + 1];
+				}
+			}
+			else
+			{
+				for (j = half; j--; )
+				{
+					s[j] = in[(j << 1)];
+					d[j] = in[(j << 1) + 1];
+				}
+			}
+			
+			// Lift and scale
+			
+			for (j = 0; j < scheme.mNSteps; j++)
+				liftStep(scheme.mSteps[j], s, d, half, 1.0);
+			
+			HISSTools_SIMD::scale(s, s, scheme.mScale, half);
+			HISSTools_SIMD::scale(d, d, scheme.mDetailScale, half);
+		}
+		
+		HISSTools_SIMD::copy(out, s, length);
+		
+		return TRUE;
+	}
+	
+	
+	bool inverseDWT (double *in, double *out, unsigned long length, unsigned long levels, LiftingWavelet wavelet)
+	{
+		const LiftingScheme &scheme = getLiftingScheme(wavelet);
+		
+		double *s = mTemp;
+		unsigned long i, j, half;
+		
+		// Sanity Check
+		
+		if (length > mMaxLength || !validLength(length, levels))
+			return FALSE;
+		
+		if (!levels)
+		{
+			if (in != out)
+				HISSTools_SIMD::copy(out, in, length);
+			return TRUE;
+		}
+		
+		half = length >> levels;
+		HISSTools_SIMD::scale(s, in, 1.0 / scheme.mScale, half);
+		
+		for (i = 0; i < levels; i++, half <<= 1)
+		{
+			double *d = mTemp + half;
+			
+			// Gather (unscaling the approximation from the previous level, and the details from the input)
+			
+			if (i)
+				HISSTools_SIMD::scale(s, out, 1.0 / scheme.mScale, half);
+			
+			HISSTools_SIMD::scale(d, in + half, 1.0 / scheme.mDetailScale, half);
+			
+			// Undo the lifting steps in reverse order
+			
+			for (j = scheme.mNSteps; j--; )
+				liftStep(scheme.mSteps[j], s, d, half, -1.0);
+			
+			// Merge
+			
+			for (j = 0; j < half; j++)
+			{
+				out[(j << 1)] = s[j];
+				out[(j << 1) + 1] = d[j];
+			}
+		}
+		
+		return TRUE;
+	}
+	
+	
+	bool forwardDWT (double *io, unsigned long length, unsigned long levels, LiftingWavelet wavelet)
+	{
+		return forwardDWT (io, io, length, levels, wavelet);
+	}
+	
+	
+	bool inverseDWT (double *io, unsigned long length, unsigned long levels, LiftingWavelet wavelet)
+	{
+		return inverseDWT (io, io, length, levels, wavelet);
+	}
+	
+	
+private:
+	
+	// A lifting step adds (gain1 * x[n]) + (gain2 * x[n + offset]) to y[n], where x and y are the s and d halves
+	
+	struct LiftingStep
+	{
+		bool mUpdate;
+		double mGain1;
+		double mGain2;
+		long mOffset;
+	};
+	
+	// The scale is applied to s, and the detail scale to d (normally the reciprocal of the scale)
+	
+	struct LiftingScheme
+	{
+		LiftingStep mSteps[4];
+		unsigned long mNSteps;
+		double mScale;
+		double mDetailScale;
+	};
+	
+	static const LiftingScheme& getLiftingScheme(LiftingWavelet wavelet)
+	{
+		static const double sqrt2 = sqrt(2.0);
+		static const double sqrt3 = sqrt(3.0);
+		
+		// The Haar predict gives odd - even, so the detail scale is negated to give (even - odd) / sqrt(2) as the filters do
+		
+		static const LiftingScheme haar = {{{FALSE, -1.0, 0.0, 0}, {TRUE, 0.5, 0.0, 0}}, 2, sqrt2, -1.0 / sqrt2};
+		
+		static const LiftingScheme d4 = {{
+			{TRUE, sqrt3, 0.0, 0},
+			{FALSE, -sqrt3 / 4.0, -(sqrt3 - 2.0) / 4.0, -1},
+			{TRUE, 0.0, -1.0, 1}}, 3, (sqrt3 - 1.0) / sqrt2, 1.0 / ((sqrt3 - 1.0) / sqrt2)};
+		
+		static const LiftingScheme cdf97 = {{
+			{FALSE, -1.586134342059924, -1.586134342059924, 1},
+			{TRUE, -0.052980118572961, -0.052980118572961, -1},
+			{FALSE, 0.882911075530934, 0.882911075530934, 1},
+			{TRUE, 0.443506852043971, 0.443506852043971, -1}}, 4, 1.149604398860241, 1.0 / 1.149604398860241};
+		
+		switch (wavelet)
+		{
+			case kLiftingHaar:		return haar;
+			case kLiftingD4:		return d4;
+			case kLiftingCDF97:		break;
+		}
+		
+		return cdf97;
+	}
+	
+	static bool validLength(unsigned long length, unsigned long levels)
+	{
+		return levels < (sizeof(unsigned long) * 8) && length && !(length & ((1UL << levels) - 1));
+	}
+	
+	// Apply (direction 1.0) or undo (direction -1.0) a single step with periodic wrapping at the edges
+	
+	static void liftStep(const LiftingStep &step, double *s, double *d, unsigned long half, double direction)
+	{
+		double *y = step.mUpdate ? s : d;
+		double *x = step.mUpdate ? d : s;
+		double gain1 = step.mGain1 * direction;
+		double gain2 = step.mGain2 * direction;
+		
+		if (step.mOffset > 0)
+		{
+			HISSTools_SIMD::lift(y, x, x + 1, gain1, gain2, half - 1);
+			y[half - 1] += (x[half - 1] * gain1) + (x[0] * gain2);
+		}
+		else if (step.mOffset < 0)
+		{
+			y[0] += (x[0] * gain1) + (x[half - 1] * gain2);
+			HISSTools_SIMD::lift(y + 1, x + 1, x, gain1, gain2, half - 1);
+		}
+		else
+			HISSTools_SIMD::lift(y, x, x, gain1, gain2, half);
+	}
+	
+	
 private:
 	
 	// Temp Data
@@ -343,4 +970,221 @@ private:
 	
 };
 
+
+// A DWT with a filter length fixed at compile time (so that the inner correlation loops can be fully unrolled and vectorised)
+
+// The filters are copied from a wavelet of exactly L taps (see HISSTools_Wavelet_Library for standard wavelets and their lengths)
+// The output is in the same layout as HISSTools_DWT (approximation first, then details from coarsest to finest)
+
+template <unsigned long L>
+class HISSTools_Fixed_DWT
+{
+
+public:
+
+	HISSTools_Fixed_DWT(unsigned long maxLength, const HISSTools_Wavelet *wavelet = NULL)
+	: mForwardOffset(0), mInverseOffset(0), mValid(FALSE)
+	{
+		mTemp = HISSTools_SIMD::allocate<double>(maxLength);
+		mMaxLength = mTemp ? maxLength : 0;
+		
+		if (wavelet)
+			setWavelet(wavelet);
+	}
+	
+	
+	~HISSTools_Fixed_DWT()
+	{
+		HISSTools_SIMD::deallocate(mTemp);
+	}
+	
+	
+	// Non-copyable
+	
+	HISSTools_Fixed_DWT(const HISSTools_Fixed_DWT&) = delete;
+	HISSTools_Fixed_DWT& operator=(const HISSTools_Fixed_DWT&) = delete;
+	
+	
+	// Copy the filters of a wavelet (returns FALSE and leaves the transforms unusable if either length is not L)
+	
+	bool setWavelet(const HISSTools_Wavelet *wavelet)
+	{
+		mValid = wavelet->mForwardLength == L && wavelet->mInverseLength == L;
+		
+		if (!mValid)
+			return FALSE;
+		
+		for (unsigned long i = 0; i < L; i++)
+		{
+			mForwardLoPass[i] = wavelet->mForwardLoPass[i];
+			mForwardHiPass[i] = wavelet->mForwardHiPass[i];
+			mInverseLoPass[i] = wavelet->mInverseLoPass[i];
+			mInverseHiPass[i] = wavelet->mInverseHiPass[i];
+		}
+		
+		mForwardOffset = (long) wavelet->mForwardOffset;
+		mInverseOffset = (long) wavelet->mInverseOffset;
+		
+		return TRUE;
+	}
+	
+	
+	bool forwardDWT(double *in, double *out, unsigned long length, unsigned long levels)
+	{
+		// Sanity Check
+		
+		if (!checkSizes(length, levels))
+			return FALSE;
+		
+		for (unsigned long i = 0; i < levels; i++, length >>= 1)
+		{
+			forwardLevel(i ? out : in, mTemp, length);
+			HISSTools_SIMD::copy(out, mTemp, length);
+		}
+		
+		if (!levels && in != out)
+			HISSTools_SIMD::copy(out, in, length);
+		
+		return TRUE;
+	}
+	
+	
+	bool inverseDWT(double *in, double *out, unsigned long length, unsigned long levels)
+	{
+		// Sanity Check
+		
+		if (!checkSizes(length, levels))
+			return FALSE;
+		
+		if (!levels)
+		{
+			if (in != out)
+				HISSTools_SIMD::copy(out, in, length);
+			return TRUE;
+		}
+		
+		length >>= (levels - 1);
+		
+		for (unsigned long i = 0; i < levels; i++, length <<= 1)
+		{
+			inverseLevel(i ? out : in, in + (length >> 1), mTemp, length);
+			HISSTools_SIMD::copy(out, mTemp, length);
+		}
+		
+		return TRUE;
+	}
+	
+	
+	bool forwardDWT(double *io, unsigned long length, unsigned long levels)
+	{
+		return forwardDWT(io, io, length, levels);
+	}
+	
+	
+	bool inverseDWT(double *io, unsigned long length, unsigned long levels)
+	{
+		return inverseDWT(io, io, length, levels);
+	}
+
+
+private:
+
+	bool checkSizes(unsigned long length, unsigned long levels)
+	{
+		if (!mValid || length > mMaxLength || levels >= (sizeof(unsigned long) * 8) || !length || (length & ((1UL << levels) - 1)))
+			return FALSE;
+		
+		return !levels || (length >> (levels - 1)) >= L;
+	}
+	
+	static unsigned long wrap(long position, unsigned long length)
+	{
+		long wrapped = position % (long) length;
+		
+		return wrapped < 0 ? wrapped + length : wrapped;
+	}
+	
+	// Single levels - the filters only wrap for the few outputs at the edges, and the rest use a loop of constant length
+	
+	void forwardLevel(const double *in, double *out, unsigned long length)
+	{
+		unsigned long half = length >> 1;
+		
+		for (unsigned long i = 0; i < half; i++)
+		{
+			unsigned long position = wrap((long) (i << 1) + mForwardOffset, length);
+			double lo = 0.0;
+			double hi = 0.0;
+			
+			if (position + L <= length)
+			{
+				const double *samples = in + position;
+				
+				for (unsigned long j = 0; j < L; j++)
+				{
+					lo += mForwardLoPass[j] * samples[j];
+					hi += mForwardHiPass[j] * samples[j];
+				}
+			}
+			else
+			{
+				for (unsigned long j = 0; j < L; j++, position = position + 1 == length ? 0 : position + 1)
+				{
+					lo += mForwardLoPass[j] * in[position];
+					hi += mForwardHiPass[j] * in[position];
+				}
+			}
+			
+			out[i] = lo;
+			out[i + half] = hi;
+		}
+	}
+	
+	void inverseLevel(const double *lo, const double *hi, double *out, unsigned long length)
+	{
+		unsigned long half = length >> 1;
+		
+		for (unsigned long i = 0; i < length; i++)
+			out[i] = 0.0;
+		
+		for (unsigned long i = 0; i < half; i++)
+		{
+			unsigned long position = wrap((long) (i << 1) + mInverseOffset, length);
+			double loVal = lo[i];
+			double hiVal = hi[i];
+			
+			if (position + L <= length)
+			{
+				double *samples = out + position;
+				
+				for (unsigned long j = 0; j < L; j++)
+					samples[j] += (mInverseLoPass[j] * loVal) + (mInverseHiPass[j] * hiVal);
+			}
+			else
+			{
+				for (unsigned long j = 0; j < L; j++, position = position + 1 == length ? 0 : position + 1)
+					out[position] += (mInverseLoPass[j] * loVal) + (mInverseHiPass[j] * hiVal);
+			}
+		}
+	}
+	
+	// FIR Filters
+	
+	double mForwardLoPass[L];
+	double mForwardHiPass[L];
+	double mInverseLoPass[L];
+	double mInverseHiPass[L];
+	
+	// Parameters
+	
+	long mForwardOffset;
+	long mInverseOffset;
+	bool mValid;
+	
+	// Temp Data
+	
+	double *mTemp;
+	unsigned long mMaxLength;
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,286 @@
+
+
+#ifndef __HISSTOOLS_DWT_BATCH__
+#define __HISSTOOLS_DWT_BATCH__
+
+#include <algorithm>
+#include "HISSTools_DWT.hpp"
+#include "HISSTools_SIMD.hpp"
+#include "../HISSTools_Utility/HISSTools_ThreadSafety.hpp"
+
+
+// Batched multi-level DWT / IDWT for many equal-length frames (for instance the log spectra of a whole file)
+
+// Frames are stored as a structure of arrays - sample i of frame f is at [i * nFrames + f] (see gather() and scatter())
+// Each filter tap is applied to a whole row of frames at once using HISSTools_SIMD, so the per tap work is shared by all frames
+// The coefficients of each frame are in the same layout as HISSTools_DWT (approximation, then details from coarsest to finest)
+// Results agree with HISSTools_DWT to within rounding (taps are summed in pairs, so expect differences of the order of 1e-15 for unit level input)
+
+// With a worker pool the frames are split into blocks of columns which are transformed as independent tasks
+
+class HISSTools_DWT_Batch
+{
+
+public:
+
+	HISSTools_DWT_Batch(unsigned long maxLength, unsigned long maxFrames)
+	: mPool(NULL)
+	{
+		mScratch = HISSTools_SIMD::allocate<double>(maxLength * maxFrames);
+
+		mMaxLength = mScratch ? maxLength : 0;
+		mMaxFrames = mScratch ? maxFrames : 0;
+	}
+
+
+	~HISSTools_DWT_Batch()
+	{
+		HISSTools_SIMD::deallocate(mScratch);
+	}
+
+
+	// Non-copyable
+
+	HISSTools_DWT_Batch(const HISSTools_DWT_Batch&) = delete;
+	HISSTools_DWT_Batch& operator=(const HISSTools_DWT_Batch&) = delete;
+
+
+	// Parallel mode - blocks of frames are transformed as tasks on a shared worker pool (pass NULL to switch off)
+	// Not threadsafe - call when not transforming
+
+	void setParallel(HISSTools_WorkerPool *pool)
+	{
+		mPool = pool;
+	}
+
+
+	// Conversion between separate frames and the batch layout
+
+	static void gather(double *out, const double * const *frames, unsigned long length, unsigned long nFrames)
+	{
+		for (unsigned long i = 0; i < length; i++)
+			for (unsigned long j = 0; j < nFrames; j++)
+				out[i * nFrames + j] = frames[j][i];
+	}
+
+	static void scatter(double **frames, const double *in, unsigned long length, unsigned long nFrames)
+	{
+		for (unsigned long i = 0; i < length; i++)
+			for (unsigned long j = 0; j < nFrames; j++)
+				frames[j][i] = in[i * nFrames + j];
+	}
+
+
+	// Transforms (the input and output may be the same)
+
+	bool forwardDWT(double *in, double *out, unsigned long length, unsigned long levels, unsigned long nFrames, HISSTools_Wavelet *wavelet)
+	{
+		return transform(in, out, length, levels, nFrames, wavelet, FALSE);
+	}
+
+
+	bool inverseDWT(double *in, double *out, unsigned long length, unsigned long levels, unsigned long nFrames, HISSTools_Wavelet *wavelet)
+	{
+		return transform(in, out, length, levels, nFrames, wavelet, TRUE);
+	}
+
+
+	bool forwardDWT(double *io, unsigned long length, unsigned long levels, unsigned long nFrames, HISSTools_Wavelet *wavelet)
+	{
+		return forwardDWT(io, io, length, levels, nFrames, wavelet);
+	}
+
+
+	bool inverseDWT(double *io, unsigned long length, unsigned long levels, unsigned long nFrames, HISSTools_Wavelet *wavelet)
+	{
+		return inverseDWT(io, io, length, levels, nFrames, wavelet);
+	}
+
+
+private:
+
+	// Per block transforms (run directly or as tasks on the worker pool)
+
+	struct Batch
+	{
+		HISSTools_DWT_Batch *mOwner;
+		const double *mIn;
+		double *mOut;
+		HISSTools_Wavelet *mWavelet;
+		unsigned long mLength;
+		unsigned long mLevels;
+		unsigned long mNFrames;
+		unsigned long mBlockSize;
+		bool mInverse;
+	};
+
+	static void blockTask(void *context, unsigned long task)
+	{
+		Batch *batch = static_cast<Batch *>(context);
+		unsigned long first = task * batch->mBlockSize;
+		unsigned long count = std::min(batch->mBlockSize, batch->mNFrames - first);
+
+		if (batch->mInverse)
+			batch->mOwner->inverseBlock(*batch, first, count);
+		else
+			batch->mOwner->forwardBlock(*batch, first, count);
+	}
+
+	bool transform(double *in, double *out, unsigned long length, unsigned long levels, unsigned long nFrames, HISSTools_Wavelet *wavelet, bool inverse)
+	{
+		unsigned long waveletLength = inverse ? wavelet->mInverseLength : wavelet->mForwardLength;
+
+		// Sanity Check
+
+		if (length > mMaxLength || nFrames > mMaxFrames || levels >= (sizeof(unsigned long) * 8) || (length & ((1UL << levels) - 1)))
+			return FALSE;
+
+		if (!nFrames || !length)
+			return TRUE;
+
+		if (!levels)
+		{
+			if (in != out)
+				HISSTools_SIMD::copy(out, in, length * nFrames);
+			return TRUE;
+		}
+
+		if (!waveletLength || waveletLength > (length >> (levels - 1)))
+			return FALSE;
+
+		// One block of frames per thread, including the calling thread (block widths are rounded to a cache line of frames)
+		// Rows are nFrames apart and not padded, so neighbouring blocks share cache lines unless nFrames is a multiple of a cache line of frames
+
+		unsigned long nThreads = mPool ? mPool->getNThreads() + 1 : 1;
+		unsigned long blockSize = std::min(HISSTools_SIMD::alignedSize((nFrames + nThreads - 1) / nThreads, sizeof(double)), nFrames);
+		unsigned long nBlocks = (nFrames + blockSize - 1) / blockSize;
+
+		Batch batch = {this, in, out, wavelet, length, levels, nFrames, blockSize, inverse};
+
+		if (mPool)
+			mPool->parallelFor(&HISSTools_DWT_Batch::blockTask, &batch, nBlocks);
+		else
+		{
+			for (unsigned long i = 0; i < nBlocks; i++)
+				blockTask(&batch, i);
+		}
+
+		return TRUE;
+	}
+
+	static unsigned long wrap(long position, unsigned long length)
+	{
+		long wrapped = position % (long) length;
+
+		return wrapped < 0 ? wrapped + length : wrapped;
+	}
+
+	// Copy the rows of a block (the whole rows if the block covers every frame)
+
+	static void copyRows(double *out, const double *in, unsigned long nRows, unsigned long nFrames, unsigned long first, unsigned long count)
+	{
+		if (count == nFrames)
+			HISSTools_SIMD::copy(out, in, nRows * nFrames);
+		else
+		{
+			for (unsigned long i = 0; i < nRows; i++)
+				HISSTools_SIMD::copy(out + i * nFrames + first, in + i * nFrames + first, count);
+		}
+	}
+
+	static void zeroRows(double *io, unsigned long nRows, unsigned long nFrames, unsigned long first, unsigned long count)
+	{
+		for (unsigned long i = 0; i < nRows; i++)
+			for (unsigned long j = first; j < first + count; j++)
+				io[i * nFrames + j] = 0.0;
+	}
+
+	// Each level is written to the scratch rows of the block, and then copied to the output
+
+	void forwardBlock(const Batch &batch, unsigned long first, unsigned long count)
+	{
+		const double *loPass = batch.mWavelet->mForwardLoPass;
+		const double *hiPass = batch.mWavelet->mForwardHiPass;
+		unsigned long waveletLength = batch.mWavelet->mForwardLength;
+		long offset = batch.mWavelet->mForwardOffset;
+		unsigned long nFrames = batch.mNFrames;
+
+		for (unsigned long i = 0, length = batch.mLength; i < batch.mLevels; i++, length >>= 1)
+		{
+			const double *source = (i ? batch.mOut : batch.mIn) + first;
+			unsigned long half = length >> 1;
+
+			zeroRows(mScratch, length, nFrames, first, count);
+
+			for (unsigned long k = 0; k < half; k++)
+			{
+				double *lo = mScratch + k * nFrames + first;
+				double *hi = mScratch + (k + half) * nFrames + first;
+				unsigned long position = wrap((long) (k << 1) + offset, length);
+
+				// Taps are applied in pairs
+
+				for (unsigned long j = 0; j < waveletLength; j += 2)
+				{
+					unsigned long next = position + 1 == length ? 0 : position + 1;
+					bool pair = j + 1 < waveletLength;
+
+					const double *in1 = source + position * nFrames;
+					const double *in2 = pair ? source + next * nFrames : in1;
+
+					HISSTools_SIMD::lift(lo, in1, in2, loPass[j], pair ? loPass[j + 1] : 0.0, count);
+					HISSTools_SIMD::lift(hi, in1, in2, hiPass[j], pair ? hiPass[j + 1] : 0.0, count);
+
+					position = next + 1 == length ? 0 : next + 1;
+				}
+			}
+
+			copyRows(batch.mOut, mScratch, length, nFrames, first, count);
+		}
+	}
+
+	void inverseBlock(const Batch &batch, unsigned long first, unsigned long count)
+	{
+		const double *loPass = batch.mWavelet->mInverseLoPass;
+		const double *hiPass = batch.mWavelet->mInverseHiPass;
+		unsigned long waveletLength = batch.mWavelet->mInverseLength;
+		long offset = batch.mWavelet->mInverseOffset;
+		unsigned long nFrames = batch.mNFrames;
+
+		for (unsigned long i = batch.mLevels, length = batch.mLength >> (batch.mLevels - 1); i--; length <<= 1)
+		{
+			const double *source = (i + 1 == batch.mLevels ? batch.mIn : batch.mOut) + first;
+			unsigned long half = length >> 1;
+
+			zeroRows(mScratch, length, nFrames, first, count);
+
+			for (unsigned long k = 0; k < half; k++)
+			{
+				const double *lo = source + k * nFrames;
+				const double *hi = batch.mIn + (k + half) * nFrames + first;
+				unsigned long position = wrap((long) (k << 1) + offset, length);
+
+				for (unsigned long j = 0; j < waveletLength; j++, position = position + 1 == length ? 0 : position + 1)
+					HISSTools_SIMD::lift(mScratch + position * nFrames + first, lo, hi, loPass[j], hiPass[j], count);
+			}
+
+			copyRows(batch.mOut, mScratch, length, nFrames, first, count);
+		}
+	}
+
+	// Parameters
+
+	unsigned long mMaxLength;
+	unsigned long mMaxFrames;
+
+	// Scratch (one row per sample - blocks use disjoint columns)
+
+	double *mScratch;
+
+	// Worker pool
+
+	HISSTools_WorkerPool *mPool;
+};
+
+
+#endif
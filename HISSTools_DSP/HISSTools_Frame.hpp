@@ -3,16 +3,23 @@
 #ifndef __HISSTOOLS_FRAME__
 #define __HISSTOOLS_FRAME__
 
+#include <cassert>
 #include <cmath>
 #include "HISSTools_IOStream.hpp"
+#include "HISSTools_Async_Frames.hpp"
 
-class HISSTools_Frame {
+// Templated on sample type (see the typedefs at the end of the file)
+
+template <class T>
+class HISSTools_Frame_T {
 	
 public:
 	
-	HISSTools_Frame(unsigned long maxFrameSize, unsigned long maxChans)
+    typedef typename HISSTools_IOStream_T<T>::View View;
+	
+	HISSTools_Frame_T(unsigned long maxFrameSize, unsigned long maxChans)
 	{
-        mInputStream = new HISSTools_IOStream(HISSTools_IOStream::kInput, maxFrameSize, maxChans);
+        mInputStream = new HISSTools_IOStream_T<T>(HISSTools_IOStream_T<T>::kInput, maxFrameSize, maxChans);
         
         mMaxFrameSize = mInputStream->getBufferSize();
         mNChans = mInputStream->getNChans();
@@ -20,18 +27,26 @@ public:
 		// Allocate individual channel pointers
 		
 		for (unsigned long i = 0; i < mNChans; i++)
-			mFrameBuffers[i] = new double[mMaxFrameSize];
+			mFrameBuffers[i] = new T[mMaxFrameSize];
 	
         mBlockHopCounter = 0;
         mHopShift = 0;
+        mAsync = NULL;
+        mOverruns = 0;
         
         reset();
 		setParams(maxFrameSize, maxFrameSize, TRUE);
 	}
 		
 	
-	~HISSTools_Frame()
+	~HISSTools_Frame_T()
 	{
+        // Derived classes using async mode must call setAsync(FALSE) in their own destructor
+        // The worker may otherwise call process() on a partially destroyed object (so it cannot be stopped safely here)
+        
+        assert(!mAsync && "call setAsync(FALSE) in the destructor of the derived class");
+        delete mAsync;
+        
         // Delete Stream
         
         delete mInputStream;
@@ -66,7 +81,7 @@ private:
         return hopCounter;
     }
     
-    bool streamToFrame(double **ins, unsigned long nChans, unsigned long nSamps, bool SingleChannel)
+    bool streamToFrame(T **ins, unsigned long nChans, unsigned long nSamps, bool SingleChannel)
 	{
         bool processedFrames = FALSE;
         
@@ -76,6 +91,8 @@ private:
 		double hopSize;
         double hopCounter;
         
+        View frameView;
+        
 		// Sanity Check
         
 		if (nChans > mNChans)
@@ -115,12 +132,14 @@ private:
                 hopCounter = hopCounter <= 0.0 ? 0.0: hopCounter;
                 hopCounter = hopCounter >= 1.0 ? 0.0: hopCounter;
                 
-                mInputStream->read(mFrameBuffers, nChans, frameSize, 0);
+                mInputStream->view(frameView, nChans, frameSize);
 				
-                if (SingleChannel == TRUE)
-                    process(mFrameBuffers[0], frameSize, hopCounter ? 1.0 - hopCounter : 0.0);
+                if (mAsync)
+                    asyncFrame(frameView, frameSize, nChans, hopCounter ? 1.0 - hopCounter : 0.0, SingleChannel == FALSE);
+                else if (SingleChannel == TRUE)
+                    processView(frameView, frameSize, hopCounter ? 1.0 - hopCounter : 0.0);
                 else
-                    process(mFrameBuffers, frameSize, nChans, hopCounter ? 1.0 - hopCounter : 0.0);
+                    processView(frameView, frameSize, nChans, hopCounter ? 1.0 - hopCounter : 0.0);
 			}
 			
 			// Check loop size
@@ -138,42 +157,92 @@ private:
 		return processedFrames;
 	}
 
+    void asyncFrame(const View &frames, unsigned long frameSize, unsigned long nChans, double fractionalOffset, bool multichannel)
+    {
+        // Copy the frame to a free slot and hand it to the worker (or drop it if the worker is behind)
+        
+        long slot = mAsync->acquire();
+        
+        if (slot < 0)
+        {
+            mOverruns++;
+            return;
+        }
+        
+        typename HISSTools_Async_Frames<T>::Slot &asyncSlot = mAsync->getSlot(slot);
+        
+        frames.copy(asyncSlot.mFrames);
+        asyncSlot.mFrameSize = frameSize;
+        asyncSlot.mNChans = nChans;
+        asyncSlot.mFractionalOffset = fractionalOffset;
+        asyncSlot.mMultichannel = multichannel;
+        
+        // Results are not collected, so the slot is reused as soon as the worker is done with it
+        
+        mAsync->submit(slot);
+        mAsync->abandon(slot);
+    }
+    
+    void processSlot(typename HISSTools_Async_Frames<T>::Slot &slot)
+    {
+        if (slot.mMultichannel)
+            process(slot.mFrames, slot.mFrameSize, slot.mNChans, slot.mFractionalOffset);
+        else
+            process(slot.mFrames[0], slot.mFrameSize, slot.mFractionalOffset);
+    }
 	
 protected:
 	
-	void virtual process(double *iFrame, unsigned long frameSize)
+	void virtual process(T *iFrame, unsigned long frameSize)
 	{
 		// This function should be overridden for single channel operation (where you wish to ignore fractional offsets).
 	}
 	
-	void virtual process(double **iFrames, unsigned long frameSize, unsigned long nChans)
+	void virtual process(T **iFrames, unsigned long frameSize, unsigned long nChans)
 	{
 		// This function should be overridden for multichannel operation (where you wish to ignore fractional offsets).
 	}
 	
-    void virtual process(double *iFrame, unsigned long frameSize, double fractionalOffset)
+    void virtual process(T *iFrame, unsigned long frameSize, double fractionalOffset)
 	{
 		// This function should be overridden for single channel operation (where you wish to receive fractional offsets)
         
         process(iFrame, frameSize);
 	}
 	
-	void virtual process(double **iFrames, unsigned long frameSize, unsigned long nChans, double fractionalOffset)
+	void virtual process(T **iFrames, unsigned long frameSize, unsigned long nChans, double fractionalOffset)
 	{
 		// This function should be overridden for multichannel operation where you wish to receive fractional offsets).
         
         process(iFrames, frameSize, nChans);
 	}
 	
+    void virtual processView(const View &frame, unsigned long frameSize, double fractionalOffset)
+    {
+        // This function should be overridden for zero-copy single channel operation.
+        // The frame is a view onto the input stream in (up to) two segments - by default it is copied to mFrameBuffers for process()
+        
+        frame.copy(mFrameBuffers[0], 0);
+        process(mFrameBuffers[0], frameSize, fractionalOffset);
+    }
+    
+    void virtual processView(const View &frames, unsigned long frameSize, unsigned long nChans, double fractionalOffset)
+    {
+        // This function should be overridden for zero-copy multichannel operation (as above).
+        
+        frames.copy(mFrameBuffers);
+        process(mFrameBuffers, frameSize, nChans, fractionalOffset);
+    }
+	
 public:
 	
 	   
-    bool streamToFrame(double *in, unsigned long nSamps)
+    bool streamToFrame(T *in, unsigned long nSamps)
 	{
 		return streamToFrame(&in, 1UL, nSamps, TRUE);
     }
 	
-    bool streamToFrame(double **ins, unsigned long nChans, unsigned long nSamps)
+    bool streamToFrame(T **ins, unsigned long nChans, unsigned long nSamps)
 	{
 		return streamToFrame(ins, nChans, nSamps, FALSE);
     }
@@ -205,6 +274,24 @@ public:
         mResetStrean = TRUE;
         mResetHopCount = TRUE;
 	}
+    
+    // Asynchronous mode - frames are copied and processed in order on a worker thread (process() is called on that thread)
+    // processView() is bypassed, and frames are dropped (and counted as overruns) if all nSlots frames are still waiting
+    // Not threadsafe - call when not streaming (derived classes must switch async mode off before they are destroyed)
+    
+    void setAsync(bool async, unsigned long nSlots = 4)
+    {
+        delete mAsync;
+        mAsync = NULL;
+        
+        if (async == TRUE)
+            mAsync = new HISSTools_Async_Frames<T>(mMaxFrameSize, mNChans, nSlots, std::bind(&HISSTools_Frame_T::processSlot, this, std::placeholders::_1));
+    }
+    
+    unsigned long getOverruns() const
+    {
+        return mOverruns;
+    }
 	
 // FIX - look at what is private here....
 // FIX - add last frame facility
@@ -212,10 +299,15 @@ public:
 	
 private:
 	
-	HISSTools_IOStream *mInputStream;
+	HISSTools_IOStream_T<T> *mInputStream;
+    
+    // Asynchronous Processing
+    
+    HISSTools_Async_Frames<T> *mAsync;
+    std::atomic<unsigned long> mOverruns;
 
 protected:
-	double *mFrameBuffers[256];
+	T *mFrameBuffers[256];
 
 private:
 
@@ -241,4 +333,8 @@ private:
 };
 
 
+typedef HISSTools_Frame_T<double> HISSTools_Frame;
+typedef HISSTools_Frame_T<float> HISSTools_Frame_Float;
+
+
 #endif
\ No newline at end of file
@@ -3,13 +3,24 @@
 #ifndef __HISSTOOLS_FRAME_DELAY__
 #define __HISSTOOLS_FRAME_DELAY__
 
+#include <algorithm>
+#include <cstdint>
+#include "HISSTools_SIMD.hpp"
+
 
 class HISSTools_Frame_Delay
 {
 	
 public:
 	
-	HISSTools_Frame_Delay(unsigned long maxFrameSize, unsigned long maxNumFrames, unsigned long maxChans = 1) 
+	// Storage format for the frame history (IO is always double precision)
+	// kStoreFloat - half the memory of double, with a relative error of at most 2^-24 (~6e-8) per value
+	// kStoreHalf - a quarter of the memory, with a relative error of at most 2^-11 (~4.9e-4) per value above 6.1e-5
+	// (values below that have an absolute error of at most 2^-25 (~3e-8), and magnitudes above 65504 are saturated)
+	
+	enum StorageFormat {kStoreDouble, kStoreFloat, kStoreHalf};
+	
+	HISSTools_Frame_Delay(unsigned long maxFrameSize, unsigned long maxNumFrames, unsigned long maxChans = 1, StorageFormat format = kStoreDouble) 
 	{
 		bool success;
 		unsigned long i;
@@ -31,10 +42,18 @@ public:
 		mMaxFrameSize = 0;
 		mMaxNumFrames = 0;
 		mFrameData = 0;
+		mStaging = 0;
+		mReadFrames = 0;
+		mWritten = 0;
+		mFormat = format;
+		mElementSize = format == kStoreDouble ? sizeof(double) : (format == kStoreFloat ? sizeof(float) : sizeof(uint16_t));
+		mFrameSize = 0;
+		mValidFrames = 0;
+		mPointer = 0;
 		
 		// Allocate channel array
 		
-		mFrameData = new double *[maxChans];
+		mFrameData = new unsigned char *[maxChans];
 
 		if (mFrameData)
 			mMaxChans = maxChans;
@@ -42,7 +61,30 @@ public:
 		// Allocate individual channel pointers
 		
 		for (i = 0; i < mMaxChans; i++)
-			mFrameData[i] = new double[maxFrameSize * maxNumFrames];
+			mFrameData[i] = new unsigned char[maxFrameSize * maxNumFrames * mElementSize];
+		
+		// Reduced precision formats stage the current frame and unpack delayed frames in double precision
+		
+		if (mFormat != kStoreDouble)
+		{
+			mStaging = new double *[mMaxChans];
+			mReadFrames = new double *[mMaxChans];
+			mWritten = new bool[mMaxChans];
+			
+			for (i = 0; i < mMaxChans; i++)
+			{
+				mStaging[i] = new double[maxFrameSize];
+				mReadFrames[i] = new double[maxFrameSize];
+				mWritten[i] = FALSE;
+			}
+		}
+		
+		// Allocate a frame of zeros (returned for delays beyond the valid history)
+		
+		mZeroFrame = new double[maxFrameSize];
+		
+		for (i = 0; i < maxFrameSize; i++)
+			mZeroFrame[i] = 0.;
 		
 		for (i = 0, success = TRUE; i < mMaxChans; i++)
 			if (!mFrameData[i])
@@ -63,14 +105,28 @@ public:
 		for (unsigned long i = 0; i < mMaxChans; i++)
 			delete[] mFrameData[i];
 		
-		// Delete channel array
+		for (unsigned long i = 0; mStaging && i < mMaxChans; i++)
+		{
+			delete[] mStaging[i];
+			delete[] mReadFrames[i];
+		}
+		
+		// Delete channel arrays and zero frame
 		
 		delete[] mFrameData;
+		delete[] mStaging;
+		delete[] mReadFrames;
+		delete[] mWritten;
+		delete[] mZeroFrame;
 	};
 	
 	
 private:
 	
+	// Bins per block for per-bin delays
+	
+	static const unsigned long kBinBlock = 256;
+	
 	void reset(unsigned long frameSize)
 	{
 		mFrameSize = frameSize;
@@ -80,42 +136,109 @@ private:
 	}
 
 	
-	void SingleChannelIO(double *in, double *out, double *chanFrameData, unsigned long frameSize, unsigned long readPointer, unsigned long writePointer)
+	// Invalid delays read the current slot with a weight of zero (avoiding a separate path for the zero frame)
+	
+	unsigned long getDelayedSlot(unsigned long frameDelay, double &weight)
 	{
-		double *frameData;
-		unsigned long i;
+		if (frameDelay > mValidFrames || frameDelay >= mMaxNumFrames)
+		{
+			weight = 0.0;
+			return mPointer;
+		}
+		
+		return mPointer >= frameDelay ? mPointer - frameDelay : (mPointer + mMaxNumFrames) - frameDelay;
+	}
+	
+	
+	template <class U>
+	U *getSlot(unsigned long chan, unsigned long slot)
+	{
+		return reinterpret_cast<U *>(mFrameData[chan]) + (slot * mMaxFrameSize);
+	}
+	
+	
+	void unpackFrame(double *out, unsigned long chan, unsigned long slot, unsigned long frameSize)
+	{
+		switch (mFormat)
+		{
+			case kStoreDouble:	std::copy(getSlot<double>(chan, slot), getSlot<double>(chan, slot) + frameSize, out);	break;
+			case kStoreFloat:	HISSTools_SIMD::convert(out, getSlot<float>(chan, slot), frameSize);					break;
+			case kStoreHalf:	HISSTools_SIMD::convert(out, getSlot<uint16_t>(chan, slot), frameSize);					break;
+		}
+	}
+	
+	
+	void packFrame(unsigned long chan)
+	{
+		switch (mFormat)
+		{
+			case kStoreDouble:																		break;
+			case kStoreFloat:	HISSTools_SIMD::convert(getSlot<float>(chan, mPointer), mStaging[chan], mFrameSize);		break;
+			case kStoreHalf:	HISSTools_SIMD::convert(getSlot<uint16_t>(chan, mPointer), mStaging[chan], mFrameSize);	break;
+		}
 		
-		// Copy in current frame
+		mWritten[chan] = FALSE;
+	}
+	
+	
+	static double toDouble(double value)	{ return value; }
+	static double toDouble(float value)		{ return value; }
+	static double toDouble(uint16_t value)	{ return HISSTools_SIMD::halfToDouble(value); }
+	
+	
+	template <class U>
+	void gatherChannel(double *output, unsigned long chan, unsigned long offset, unsigned long size, const unsigned long readSlots[2][kBinBlock], const double readWeights[2][kBinBlock])
+	{
+		const U *frameData = reinterpret_cast<const U *>(mFrameData[chan]) + offset;
 		
-		for (i = 0, frameData = chanFrameData + (writePointer * mMaxFrameSize); i < frameSize; i++)
-			frameData[i] = in[i];
+		for (unsigned long i = 0; i < size; i++)
+		{
+			const U *frame1 = frameData + (readSlots[0][i] * mMaxFrameSize);
+			const U *frame2 = frameData + (readSlots[1][i] * mMaxFrameSize);
+			
+			output[i] = (toDouble(frame1[i]) * readWeights[0][i]) + (toDouble(frame2[i]) * readWeights[1][i]);
+		}
+	}
+	
+	
+	void SingleChannelIO(double *in, double *out, unsigned long chan, unsigned long frameSize, unsigned long frameDelay)
+	{
+		double weight = 1.0;
+		
+		// Copy in current frame (unless it has been written in place)
 		
-		// Get output frame
+		if (in != getWriteFrame(chan))
+			std::copy(in, in + frameSize, getWriteFrame(chan));
 		
-		if (readPointer >= 0)
+		// Copy out the delayed frame (reduced precision frames are unpacked straight to the output)
+		
+		if (mFormat == kStoreDouble || !frameDelay)
 		{
-			for (i = 0, frameData = chanFrameData + (readPointer * mMaxFrameSize); i < frameSize; i++)
-				out[i] = frameData[i];
+			const double *frameData = getDelayedFrame(chan, frameDelay);
+			std::copy(frameData, frameData + frameSize, out);
 		}
-		else 
+		else
 		{
-			for (i = 0; i < frameSize; i++)
-				out[i] = 0.;
+			unsigned long slot = getDelayedSlot(frameDelay, weight);
+			
+			if (weight)
+				unpackFrame(out, chan, slot, frameSize);
+			else
+				std::fill_n(out, frameSize, 0.0);
 		}
 	}
 	
 	
 public:
 	
+	// Zero-copy IO - call beginFrame(), write the current frame in place to getWriteFrame() for each channel, then read any delayed frames
+	// Delayed frames may be read directly from getDelayedFrame() (a delay of zero gives the current frame) until endFrame() is called
 	
-	bool delayIO(double **in, double **out, unsigned long frameSize, unsigned long nChans, unsigned long frameDelay)
+	bool beginFrame(unsigned long frameSize)
 	{
-		unsigned long writePointer;
-		unsigned long readPointer;
-		
 		// Sanity Check
 		
-		if (frameSize > mMaxFrameSize || nChans > mMaxChans)
+		if (frameSize > mMaxFrameSize)
 			return FALSE;
 		
 		// Reset
@@ -123,24 +246,134 @@ public:
 		if (frameSize != mFrameSize || mClear == TRUE)
 			reset(frameSize);
 		
-		writePointer = mPointer;
+		return TRUE;
+	}
+	
+	
+	double *getWriteFrame(unsigned long chan)
+	{
+		if (mFormat == kStoreDouble)
+			return getSlot<double>(chan, mPointer);
+		
+		mWritten[chan] = TRUE;
+		
+		return mStaging[chan];
+	}
+	
+	
+	// Returns a frame of zeros if the delay is longer than the valid history (or the maximum delay)
+	// For reduced precision formats delayed frames are unpacked to a per-channel buffer (valid until the next call for that channel)
+	
+	const double *getDelayedFrame(unsigned long chan, unsigned long frameDelay)
+	{
+		double weight = 1.0;
+		unsigned long slot = getDelayedSlot(frameDelay, weight);
 		
-		// Find output frame
+		if (!weight)
+			return mZeroFrame;
 		
-		readPointer = mPointer - frameDelay;
-		readPointer = readPointer < 0 ? readPointer + mMaxNumFrames: readPointer;
-		readPointer = frameDelay > mValidFrames ? -1 : readPointer;
+		if (mFormat == kStoreDouble)
+			return getSlot<double>(chan, slot);
+		
+		if (!frameDelay)
+			return mStaging[chan];
+		
+		unpackFrame(mReadFrames[chan], chan, slot, mFrameSize);
+		
+		return mReadFrames[chan];
+	}
+	
+	
+	void endFrame()
+	{
+		// Pack any frames written in reduced precision formats
+		
+		for (unsigned long i = 0; mFormat != kStoreDouble && i < mMaxChans; i++)
+			if (mWritten[i])
+				packFrame(i);
+		
+		mPointer = (mPointer + 1) >= mMaxNumFrames ? 0 : mPointer + 1;
+		mValidFrames = (mValidFrames + 1) >= mMaxNumFrames ? mMaxNumFrames : mValidFrames + 1;
+	}
+	
+	
+	bool delayIO(double **in, double **out, unsigned long frameSize, unsigned long nChans, unsigned long frameDelay)
+	{
+		// Sanity Check
+		
+		if (nChans > mMaxChans || !beginFrame(frameSize))
+			return FALSE;
 		
 		for (unsigned long i = 0; i < nChans; i++) 
-			SingleChannelIO(in[i], out[i], mFrameData[i], frameSize, readPointer, writePointer);
+			SingleChannelIO(in[i], out[i], i, frameSize, frameDelay);
 		
-		mPointer = ++mPointer >= mMaxNumFrames ? 0 : mPointer;
-		mValidFrames = ++mValidFrames >= mMaxNumFrames ? mMaxNumFrames : mValidFrames;
+		endFrame();
 		
 		return TRUE;
 	}
 
 	
+	// Per-bin fractional delays (in frames, shared across channels) - delays are clamped to [0, maxNumFrames] as passed to the constructor
+	// Adjacent stored frames are linearly interpolated, and delays beyond the valid history read zeros
+	
+	bool delayIO(double **in, double **out, unsigned long frameSize, unsigned long nChans, const double *binDelays)
+	{
+		unsigned long readSlots[2][kBinBlock];
+		double readWeights[2][kBinBlock];
+		
+		// Sanity Check
+		
+		if (nChans > mMaxChans || !beginFrame(frameSize))
+			return FALSE;
+		
+		// Write the current frame (packing immediately for reduced precision formats, so that it can be gathered like any other)
+		
+		for (unsigned long i = 0; i < nChans; i++)
+		{
+			if (in[i] != getWriteFrame(i))
+				std::copy(in[i], in[i] + frameSize, getWriteFrame(i));
+			
+			if (mFormat != kStoreDouble)
+				packFrame(i);
+		}
+		
+		// Work in blocks of bins, so that slots and weights are calculated once per bin and then gathered for every channel
+		
+		for (unsigned long i = 0; i < frameSize; i += kBinBlock)
+		{
+			unsigned long blockSize = (frameSize - i) < kBinBlock ? (frameSize - i) : kBinBlock;
+			
+			// N.B. mMaxNumFrames includes a slot for the current frame, so the largest delay is mMaxNumFrames - 1 (maxNumFrames)
+			
+			for (unsigned long j = 0; j < blockSize; j++)
+			{
+				double delay = std::max(0.0, std::min(binDelays[i + j], (double) (mMaxNumFrames - 1)));
+				unsigned long frameDelay = (unsigned long) delay;
+				double fract = delay - frameDelay;
+				
+				readWeights[0][j] = 1.0 - fract;
+				readWeights[1][j] = fract;
+				readSlots[0][j] = getDelayedSlot(frameDelay, readWeights[0][j]);
+				readSlots[1][j] = getDelayedSlot(frameDelay + 1, readWeights[1][j]);
+			}
+			
+			for (unsigned long j = 0; j < nChans; j++)
+			{
+				switch (mFormat)
+				{
+					case kStoreDouble:	gatherChannel<double>(out[j] + i, j, i, blockSize, readSlots, readWeights);		break;
+					case kStoreFloat:	gatherChannel<float>(out[j] + i, j, i, blockSize, readSlots, readWeights);		break;
+					case kStoreHalf:	gatherChannel<uint16_t>(out[j] + i, j, i, blockSize, readSlots, readWeights);	break;
+				}
+			}
+		}
+		
+		endFrame();
+		
+		return TRUE;
+	}
+	
+	
 	void delayIO(double *in, double *out, long size, long frameDelay)
 	{
 		delayIO(&in, &out, size, 1, frameDelay);
@@ -151,13 +384,40 @@ public:
 	{
 		mClear = TRUE;
 	}
+	
+	
+	// Memory used in bytes (the frame history plus any staging buffers)
+	
+	size_t getMemoryFootprint() const
+	{
+		size_t history = (size_t) mMaxChans * mMaxNumFrames * mMaxFrameSize * mElementSize;
+		size_t buffers = (size_t) mMaxFrameSize * sizeof(double) * (mFormat == kStoreDouble ? 1 : (2 * mMaxChans) + 1);
+		
+		return history + buffers;
+	}
+	
+	
+	StorageFormat getStorageFormat() const
+	{
+		return mFormat;
+	}
 
 	
 private:
 	
 	// Data
 	
-	double **mFrameData;
+	unsigned char **mFrameData;
+	double **mStaging;
+	double **mReadFrames;
+	double *mZeroFrame;
+	
+	bool *mWritten;
+	
+	// Storage
+	
+	StorageFormat mFormat;
+	unsigned long mElementSize;
 	
 	// Current Parameters
 	
@@ -3,23 +3,85 @@
 #ifndef __HISSTOOLS_IOSTREAM__
 #define __HISSTOOLS_IOSTREAM__
 
+#include <algorithm>
+#include <cstring>
+#include "HISSTools_SIMD.hpp"
+#include "HISSTools_Mirrored_Memory.hpp"
 
-class HISSTools_IOStream {
+
+// Templated on sample type (see the typedefs at the end of the file)
+
+template <class T>
+class HISSTools_IOStream_T {
     
 public:
 	enum IOStreamMode {kInput, kOutput};
     
+    // A read-only view onto a span of the stream, held as (up to) two contiguous segments per channel
+    
+    class View
+    {
+        friend class HISSTools_IOStream_T;
+        
+    public:
+        
+        View() : mBuffers(NULL), mOffset(0), mFirstSize(0), mSecondSize(0), mNChans(0) {}
+        
+        unsigned long getNChans() const                 { return mNChans; }
+        unsigned long getSize() const                   { return mFirstSize + mSecondSize; }
+        bool isContiguous() const                       { return mSecondSize == 0; }
+        
+        // Segments (the second segment is empty if the span does not wrap)
+        
+        const T *getFirst(unsigned long chan) const     { return mBuffers[chan] + mOffset; }
+        const T *getSecond(unsigned long chan) const    { return mBuffers[chan]; }
+        unsigned long getFirstSize() const              { return mFirstSize; }
+        unsigned long getSecondSize() const             { return mSecondSize; }
+        
+        // Random access (slower than iterating over the segments)
+        
+        T operator()(unsigned long chan, unsigned long idx) const
+        {
+            return idx < mFirstSize ? mBuffers[chan][mOffset + idx] : mBuffers[chan][idx - mFirstSize];
+        }
+        
+        // Copy to contiguous memory
+        
+        void copy(T *output, unsigned long chan) const
+        {
+            HISSTools_SIMD::copy(output, getFirst(chan), mFirstSize);
+            HISSTools_SIMD::copy(output + mFirstSize, getSecond(chan), mSecondSize);
+        }
+        
+        void copy(T **outputs, unsigned long outputOffset = 0) const
+        {
+            for (unsigned long i = 0; i < mNChans; i++)
+                copy(outputs[i] + outputOffset, i);
+        }
+        
+    private:
+        
+        T *const *mBuffers;
+        unsigned long mOffset;
+        unsigned long mFirstSize;
+        unsigned long mSecondSize;
+        unsigned long mNChans;
+    };
+    
 
-	HISSTools_IOStream(IOStreamMode mode, unsigned long size, unsigned long nChans) : mMode(mode), mBufferSize(std::max(1UL, size)),
+	HISSTools_IOStream_T(IOStreamMode mode, unsigned long size, unsigned long nChans) : mMode(mode), mBufferSize(std::max(1UL, size)),
         mNChans(std::max(1UL, std::min(256UL, nChans)))
 	{
 		mBufferCounter = 0;
         mWriteOffset = mBufferSize;
         
-        // Allocate individual channel pointers
+        // Allocate (mirrored where possible, so that no access ever has to wrap)
 		
+        mMemory = new HISSTools_Mirrored_Memory<T>(mBufferSize, mNChans, true, true);
+        mMirrored = mMemory->isMirrored();
+        
 		for (unsigned long i = 0; i < mNChans; i++)
-			mBuffers[i] = new double[mBufferSize];
+			mBuffers[i] = mMemory->getRing(i);
         
         // Clear buffers
         
@@ -27,12 +89,9 @@ public:
 	}
 		
 	
-	~HISSTools_IOStream()
+	~HISSTools_IOStream_T()
 	{		
-		// Delete individual channel pointers
-
-		for (unsigned long i = 0; i < mNChans; i++)
-			delete[] mBuffers[i];
+		delete mMemory;
 	}
 	
 		
@@ -49,72 +108,80 @@ public:
 	void reset()
 	{
 		for (unsigned long i = 0; i < mNChans; i++)
-            memset(mBuffers[i], 0, mBufferSize * sizeof(double));
+            memset(mBuffers[i], 0, mBufferSize * sizeof(T));
         
         mWriteOffset = mBufferSize;
 	}
 	
-    bool read(double **outputs, unsigned long nChans, unsigned long size, unsigned long outputOffset)
+    // Get a view of the next (output mode) or most recent (input mode) samples without copying or updating the stream
+    
+    bool view(View &view, unsigned long nChans, unsigned long size)
     {
-        // Load read and write parameters locally - FIX (check the effect of this later)...
-        
         unsigned long readCounter = mBufferCounter;
-        unsigned long writeOffset = mWriteOffset;
-        
-        double *output;
         
         // Sanity check (cannot read more than has been written or more channels than stored)
-    
-        // FIX - read zeros if not enough written in output mode....
         
-        if (size > writeOffset || nChans > mNChans)
+        if (size > mWriteOffset || nChans > mNChans)
             return FALSE;
-    
+        
         // Adjust read counter if in input mode
         
         if (mMode == kInput)
             readCounter = (readCounter < size) ? mBufferSize + readCounter - size : readCounter - size;
         
-        // Check for wraparound and copy in one or two steps
+        // Check for wraparound
         
         unsigned long bufferRemain = mBufferSize - readCounter;
-        unsigned long unwrappedSize = bufferRemain > size ? size : bufferRemain;
         
-        for (unsigned long i = 0; i < nChans; i++)
-        {
-            output = outputs[i] + outputOffset;
-            
-            memcpy((void *) output, (void *) (mBuffers[i] + readCounter), unwrappedSize * sizeof (double));
-            memcpy((void *) (output + unwrappedSize), mBuffers[i], (size - unwrappedSize) * sizeof (double));
-        }
+        view.mBuffers = mBuffers;
+        view.mOffset = readCounter;
+        view.mFirstSize = (mMirrored || bufferRemain > size) ? size : bufferRemain;
+        view.mSecondSize = size - view.mFirstSize;
+        view.mNChans = nChans;
+        
+        return TRUE;
+    }
+    
+    bool read(T **outputs, unsigned long nChans, unsigned long size, unsigned long outputOffset)
+    {
+        View span;
+        
+        // FIX - read zeros if not enough written in output mode....
+        
+        if (view(span, nChans, size) == FALSE)
+            return FALSE;
+        
+        // Copy in one or two steps
+        
+        span.copy(outputs, outputOffset);
         
         // Update counter / offset if in output mode
         
         if (mMode == kOutput)
         {
-            readCounter += size;
+            unsigned long readCounter = mBufferCounter + size;
             mBufferCounter = (readCounter < mBufferSize) ? readCounter : readCounter - mBufferSize;
-            mWriteOffset = writeOffset - size;
+            mWriteOffset = mWriteOffset - size;
         }
         
         return TRUE;
     }
     
-    bool read(double *output, unsigned long size, unsigned long outputOffset)
+    bool read(T *output, unsigned long size, unsigned long outputOffset)
     {
         return read(&output, 1UL, size, outputOffset);
     }
 	
-	bool write(double **inputs, unsigned long nChans, unsigned long size, unsigned long inputOffset)
+	bool write(T **inputs, unsigned long nChans, unsigned long size, unsigned long inputOffset)
 	{
         // Load write offset parameter locally - FIX (check the effect of this later)...
         
         unsigned long writeCounter = mBufferCounter;
         unsigned long writeOffset = mWriteOffset;
-        unsigned long i, j;
+        unsigned long i;
         
-        double *bufferPointer = NULL;
-        double *input = NULL;
+        T *bufferPointer = NULL;
+        T *input = NULL;
         
 		// Sanity check (cannot write past read counter or more channels than are allocated)
         
@@ -125,33 +192,49 @@ public:
         
         unsigned long overlappedSize = (writeOffset && mMode == kOutput) ? ((writeOffset < size) ? writeOffset : size) : 0UL;
 
-        // Calculate loop sizes
-        
-        unsigned long bufferRemain = mBufferSize - writeCounter;
-        unsigned long loop1 = (bufferRemain < overlappedSize) ? bufferRemain : overlappedSize;
-        unsigned long loop2 = (bufferRemain < size) ? bufferRemain : size;
-        
-        for (i = 0; i < nChans; i++)
+        if (mMirrored)
         {
-            // Overlapping part (not wrapped)
-				
-            for (j = 0, input = inputs[i] + inputOffset, bufferPointer = mBuffers[i] + writeCounter;  j < loop1; j++)
-                *bufferPointer++ += *input++;
-		
-            // Non-overlapping part (not wrapped)
-        
-            for (; j < loop2; j++)
-                *bufferPointer++ = *input++;
-        
-            // Overlapping part (wrapped)
-        
-            for (bufferPointer -= mBufferSize; j < overlappedSize; j++)
-                *bufferPointer++ = *input++;
-        
-            // Non-overlapping part (wrapped)
+            // Mirrored memory (no need to check for wraparound)
             
-            for (; j < size; j++)
-                *bufferPointer++ = *input++;
+            for (i = 0; i < nChans; i++)
+            {
+                input = inputs[i] + inputOffset;
+                bufferPointer = mBuffers[i] + writeCounter;
+                
+                HISSTools_SIMD::accumulate(bufferPointer, input, overlappedSize);
+                HISSTools_SIMD::copy(bufferPointer + overlappedSize, input + overlappedSize, size - overlappedSize);
+            }
+        }
+        else
+        {
+            // Calculate loop sizes
+            
+            unsigned long bufferRemain = mBufferSize - writeCounter;
+            unsigned long loop1 = (bufferRemain < overlappedSize) ? bufferRemain : overlappedSize;
+            unsigned long loop2 = (bufferRemain < size) ? bufferRemain : size;
+            unsigned long loop3 = (overlappedSize > loop2) ? overlappedSize - loop2 : 0UL;
+            
+            for (i = 0; i < nChans; i++)
+            {
+                input = inputs[i] + inputOffset;
+                bufferPointer = mBuffers[i];
+                
+                // Overlapping part (not wrapped)
+                
+                HISSTools_SIMD::accumulate(bufferPointer + writeCounter, input, loop1);
+                
+                // Non-overlapping part (not wrapped)
+                
+                HISSTools_SIMD::copy(bufferPointer + writeCounter + loop1, input + loop1, loop2 - loop1);
+                
+                // Overlapping part (wrapped)
+                
+                HISSTools_SIMD::accumulate(bufferPointer, input + loop2, loop3);
+                
+                // Non-overlapping part (wrapped)
+                
+                HISSTools_SIMD::copy(bufferPointer + loop3, input + loop2 + loop3, size - (loop2 + loop3));
+            }
         }
         
         // Update counter / offset
@@ -169,7 +252,7 @@ public:
         return TRUE;
 	}
     
-    bool write(double *input, unsigned long size, unsigned long inputOffset)
+    bool write(T *input, unsigned long size, unsigned long inputOffset)
     {
         return write(&input, 1, size, inputOffset);
     }
@@ -183,7 +266,9 @@ private:
     
 	// Data
 	
-	double *mBuffers[256];
+    HISSTools_Mirrored_Memory<T> *mMemory;
+	T *mBuffers[256];
+    bool mMirrored;
 	
 	// Pointers
 	
@@ -197,4 +282,8 @@ private:
 };
 
 
+typedef HISSTools_IOStream_T<double> HISSTools_IOStream;
+typedef HISSTools_IOStream_T<float> HISSTools_IOStream_Float;
+
+
 #endif
\ No newline at end of file
@@ -0,0 +1,157 @@
+
+#ifndef __HISSTOOLS_MIRRORED_MEMORY__
+#define __HISSTOOLS_MIRRORED_MEMORY__
+
+#include <algorithm>
+#include "HISSTools_SIMD.hpp"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#if defined(SYS_memfd_create)
+#define HISSTOOLS_MIRRORED_MEMORY_MEMFD
+#endif
+#endif
+
+
+// Memory for a set of ring buffers, each of which is immediately followed by a second copy of itself
+// Where possible the second copy is a virtual memory mirror (the same physical pages mapped twice) so a single write updates both
+// Otherwise the memory is a plain allocation of the same layout, and the owner must write both copies (check isMirrored())
+// Owners that only need the second copy when it is free can request a fallback without space for it (singleFallback)
+
+// Mirroring requires each ring to be a whole number of pages (memfd + mmap on Linux only)
+
+template <class T>
+class HISSTools_Mirrored_Memory
+{
+
+public:
+
+	HISSTools_Mirrored_Memory(unsigned long ringSize, unsigned long nRings, bool allowMirroring = true, bool singleFallback = false)
+	: mMemory(NULL), mRingSize(std::max(1UL, ringSize)), mNRings(std::max(1UL, nRings)), mMappedBytes(0)
+	{
+		if (allowMirroring && canMirror(mRingSize))
+			mMemory = mapMirrored();
+
+		// Fallback (a plain allocation)
+
+		if (!mMemory)
+		{
+			mStride = HISSTools_SIMD::alignedSize(mRingSize * (singleFallback ? 1 : 2), sizeof(T));
+			mMemory = HISSTools_SIMD::allocate<T>(mStride * mNRings);
+		}
+		else
+			mStride = mRingSize * 2;
+	}
+
+	~HISSTools_Mirrored_Memory()
+	{
+#if defined(HISSTOOLS_MIRRORED_MEMORY_MEMFD)
+		if (mMappedBytes)
+		{
+			munmap(mMemory, mMappedBytes);
+			return;
+		}
+#endif
+		HISSTools_SIMD::deallocate(mMemory);
+	}
+
+	// Non-copyable
+
+	HISSTools_Mirrored_Memory(const HISSTools_Mirrored_Memory&) = delete;
+	HISSTools_Mirrored_Memory& operator=(const HISSTools_Mirrored_Memory&) = delete;
+
+	// Accessors
+
+	T *getRing(unsigned long ring)		{ return mMemory ? mMemory + (ring * mStride) : NULL; }
+	bool isMirrored() const				{ return mMappedBytes != 0; }
+	bool isValid() const				{ return mMemory != NULL; }
+
+	static bool canMirror(unsigned long ringSize)
+	{
+#if defined(HISSTOOLS_MIRRORED_MEMORY_MEMFD)
+		long pageSize = sysconf(_SC_PAGESIZE);
+
+		return pageSize > 0 && ringSize && ((ringSize * sizeof(T)) % pageSize) == 0;
+#else
+		return false;
+#endif
+	}
+
+private:
+
+	T *mapMirrored()
+	{
+#if defined(HISSTOOLS_MIRRORED_MEMORY_MEMFD)
+		size_t ringBytes = mRingSize * sizeof(T);
+		size_t totalBytes = ringBytes * mNRings;
+		char *address;
+		bool success = true;
+
+		int fd = (int) syscall(SYS_memfd_create, "HISSTools_Mirrored_Memory", 1U /* MFD_CLOEXEC */);
+
+		if (fd < 0)
+			return NULL;
+
+		if (ftruncate(fd, (off_t) totalBytes))
+		{
+			close(fd);
+			return NULL;
+		}
+
+		// Reserve contiguous address space for both copies of every ring, then map each ring's pages in twice
+
+		void *reserved = mmap(NULL, totalBytes * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if (reserved == MAP_FAILED)
+		{
+			close(fd);
+			return NULL;
+		}
+
+		address = static_cast<char *>(reserved);
+
+		for (unsigned long i = 0; success && i < mNRings; i++)
+		{
+			for (unsigned long j = 0; success && j < 2; j++)
+			{
+				void *ring = address + (((i * 2) + j) * ringBytes);
+				void *mapped = mmap(ring, ringBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, (off_t) (i * ringBytes));
+
+				success = mapped == ring;
+			}
+		}
+
+		// The mappings keep the file alive
+
+		close(fd);
+
+		if (!success)
+		{
+			munmap(reserved, totalBytes * 2);
+			return NULL;
+		}
+
+		mMappedBytes = totalBytes * 2;
+
+		return static_cast<T *>(reserved);
+#else
+		return NULL;
+#endif
+	}
+
+	// Memory
+
+	T *mMemory;
+
+	// Sizes
+
+	unsigned long mRingSize;
+	unsigned long mNRings;
+	unsigned long mStride;
+	size_t mMappedBytes;
+};
+
+
+#endif
@@ -26,10 +26,23 @@ public:
 	HISSTools_MultiTaper_Spectrum(maxFFTSize, kSpectrumFull), HISSTools_DWT(maxFFTSize), HISSTools_PSpectrum(maxFFTSize, kSpectrumFull)
 	{			
 		mWavelet = wavelet;
+		mPlan = NULL;
 	}
 	
 	~HISSTools_MultiTaper_Shrink()
 	{
+		delete mPlan;
+	}
+	
+	// Not realtime safe - builds a transform plan for an FFT size and shrink level (other sizes and levels use the unplanned transform)
+	
+	void prepare(unsigned long FFTSize, unsigned long shrinkLevel)
+	{
+		if (mPlan && mPlan->matches(mWavelet, FFTSize, shrinkLevel))
+			return;
+		
+		delete mPlan;
+		mPlan = new HISSTools_DWT_Plan(mWavelet, FFTSize, shrinkLevel);
 	}
 	
 private:
@@ -155,9 +168,17 @@ public:
 		temp[i] = temp[FFTSize - i];
 		
 		// Wavelet shrinking
-		// Transform
-			
-		forwardDWT(temp, FFTSize, shrinkLevel, mWavelet);
+		// Transform (with the plan if one was prepared for this FFT size and shrink level)
+		
+		bool planned = mPlan && mPlan->matches(mWavelet, FFTSize, shrinkLevel);
+		
+		if (planned)
+		{
+			if (mPlan->forwardDWT(temp, temp) == FALSE)
+				return FALSE;
+		}
+		else
+			forwardDWT(temp, FFTSize, shrinkLevel, mWavelet);
 			
 		// Wavelet Shrink
 			
@@ -165,7 +186,10 @@ public:
 			
 		// Transform Back
 			
-		inverseDWT(temp, FFTSize, shrinkLevel, mWavelet);
+		if (planned)
+			mPlan->inverseDWT(temp, temp);
+		else
+			inverseDWT(temp, FFTSize, shrinkLevel, mWavelet);
 		
 		// Average Results
 		// DC
@@ -194,6 +218,7 @@ public:
 private:
 	
 	HISSTools_Wavelet *mWavelet;	
+	HISSTools_DWT_Plan *mPlan;
 	HISSTools_PSpectrum *mTempPowerSpectrum;
 };
 
@@ -5,6 +5,8 @@
 
 
 #include "HISSTools_FFT.hpp"
+#include "HISSTools_SIMD.hpp"
+#include <algorithm>
 
 
 class HISSTools_MultiTaper_Spectrum : protected HISSTools_FFT, protected HISSTools_FSpectrum 
@@ -13,13 +15,28 @@ class HISSTools_MultiTaper_Spectrum : protected HISSTools_FFT, protected HISSToo
 public:
 	
 	HISSTools_MultiTaper_Spectrum (unsigned long maxFFTSize, PSpectrumFormat format = kSpectrumNyquist) : HISSTools_FFT(maxFFTSize * 2), HISSTools_FSpectrum(maxFFTSize * 2, kSpectrumComplex)
-	{		
+	{
+		// Even and odd bins of the (zero-padded) FFT data, and the number of tapers for each bin when adapting
+		
+		mSplitData = HISSTools_SIMD::allocate<double>(maxFFTSize * 5);
+		
+		mRealEven = mSplitData;
+		mRealOdd = mRealEven + maxFFTSize;
+		mImagEven = mRealOdd + maxFFTSize;
+		mImagOdd = mImagEven + maxFFTSize;
+		mTapers = mImagOdd + maxFFTSize;
 	}
 	
 	~HISSTools_MultiTaper_Spectrum()
 	{
+		HISSTools_SIMD::deallocate(mSplitData);
 	}
 	
+	// Non-copyable
+	
+	HISSTools_MultiTaper_Spectrum(const HISSTools_MultiTaper_Spectrum&) = delete;
+	HISSTools_MultiTaper_Spectrum& operator=(const HISSTools_MultiTaper_Spectrum&) = delete;
+	
 private:
 	
 	double estimateDifferential(double pm1, double p0, double pp1, double binWidth)
@@ -32,22 +49,27 @@ private:
 		return (16.0 * (pm1 + pp1) - (30.0 * p0) - (pm2 + pp2)) / (12.0 * binWidth * binWidth);
 	}
 	
-	double optimalTapers(double powValue, double powDifferential, unsigned long N)
+	double taperPower(double powValue, double powDifferential, unsigned long N)
 	{
+		// The optimal number of tapers is the fifth root of this value (see optimalTapers())
+		
 		double kTapers = (12 * powValue * (N * N)) / powDifferential;
-		kTapers = pow(kTapers * kTapers, 1.0/5.0);
-		kTapers = kTapers < 1.0 ? 1.0 : kTapers;
-		kTapers = kTapers < (N >> 2) ? kTapers : (N >> 2);
-
-		kTapers = kTapers < 20 ? kTapers : 20;
 		
-		return kTapers;//(long) round(kTapers);
+		return kTapers * kTapers;
+	}
+	
+	void optimalTapers(double *kTapers, unsigned long size, unsigned long N)
+	{
+		// Convert taper powers to the optimal number of tapers for all bins at once (clipped to 1 - 20 and a quarter of the FFT size)
+		
+		double maxTapers = (N >> 2) < 20 ? (N >> 2) : 20;
+		
+		HISSTools_SIMD::fifthRoot(kTapers, kTapers, 1.0, maxTapers < 1.0 ? 1.0 : maxTapers, size);
 	}
 	
 	void adapt(FFT_SPLIT_COMPLEX_D FFTData, PSpectrumFormat format, double *spectrum, unsigned long FFTSize, unsigned long maxBin, double scale)
 	{
-		//long kTapers[FFTSize];
-		double kTapers[16384];
+		double *kTapers = mTapers;
 		double differential;
 		double binWidth = 1.0 / FFTSize;
 		long minTapers = FFTSize;
@@ -56,14 +78,14 @@ private:
 		unsigned long FFTBinMask = (FFTSize << 1) - 1;
 		unsigned long i, j;
 		
-		// Calculate optimal tapers based on current power values
+		// Calculate optimal tapers based on current power values (taper powers first, and then the roots for all bins)
 		
 		//differential = estimateDifferential(spectrum[1], spectrum[0], spectrum[1], binWidth);
 		differential = estimateDifferential(spectrum[2], spectrum[1], spectrum[0], spectrum[1], spectrum[2], binWidth);
-		kTapers[0] = optimalTapers(spectrum[0], differential, FFTSize);
+		kTapers[0] = taperPower(spectrum[0], differential, FFTSize);
 		
 		differential = estimateDifferential(spectrum[1], spectrum[0], spectrum[1], spectrum[2], spectrum[3], binWidth);
-		kTapers[1] = optimalTapers(spectrum[1], differential, FFTSize);
+		kTapers[1] = taperPower(spectrum[1], differential, FFTSize);
 		
 		// FIX - doesn't work for half spectrum 
 		
@@ -71,17 +93,19 @@ private:
 		{
 			//differential = estimateDifferential(spectrum[i - 1], spectrum[i], spectrum[i + 1], binWidth);
 			differential = estimateDifferential(spectrum[i-2], spectrum[i-1], spectrum[i], spectrum[i+1], spectrum[i+2], binWidth);
-			kTapers[i] = optimalTapers(spectrum[i], differential, FFTSize);
+			kTapers[i] = taperPower(spectrum[i], differential, FFTSize);
 		}
 			
 		//differential = estimateDifferential(spectrum[i - 1], spectrum[i], spectrum[i - 1], binWidth);
         differential = estimateDifferential(spectrum[i-2], spectrum[i-1], spectrum[i], spectrum[i+1], spectrum[i-1], binWidth);
-        kTapers[i] = optimalTapers(spectrum[i], differential, FFTSize);
+        kTapers[i] = taperPower(spectrum[i], differential, FFTSize);
 			
         i++;
 			
         differential = estimateDifferential(spectrum[i-2], spectrum[i-1], spectrum[i], spectrum[i-1], spectrum[i-2], binWidth);
-        kTapers[i] = optimalTapers(spectrum[i], differential, FFTSize);
+        kTapers[i] = taperPower(spectrum[i], differential, FFTSize);
+		
+		optimalTapers(kTapers, maxBin, FFTSize);
 		
 		for (i = 0; i < maxBin; i++)
 		{
@@ -155,11 +179,6 @@ public:
 		double taperScale;
 		double real, imag;
 		
-		// Sanity check for number of tapers
-		
-		kTapers = kTapers < (FFTSize >> 1) ? kTapers : (FFTSize >> 1) - 1;
-		
-		weight /= kTapers;
 		scale = scale == 0 ? 1 : scale;
 		
 		// Check arguments
@@ -171,6 +190,10 @@ public:
 		
 		if (nSamps > FFTSize)
 			nSamps = FFTSize;
+		
+		// Sanity check for number of tapers (once the FFT size is known)
+		
+		kTapers = kTapers < (FFTSize >> 1) ? kTapers : (FFTSize >> 1) - 1;
 			
 		// Transform to time domain (with Sanity Check)
 		
@@ -198,37 +221,82 @@ public:
 		double weightSum = kTapers - (((1.0 / (double) kTapers) - 3.0 + 2.0 * kTapers) / 6.0);
 		double normFactor = sqrt(2.) / (2 * FFTSize * weightSum);
 				
+		// Deal with lower end wraparound (bins below kTapers)
+		
 		for (unsigned long i = 1; i <= kTapers; i++)
-		{			
+		{
 			weight = (1.0 - ((i - 1) * (i - 1)) / (double) (kTapers * kTapers));
 			taperScale = weight * scale  * normFactor;
 			
-			// Deal with lower end wraparound
-			
-			for (unsigned long j = 0; j < i; j++)
+			for (unsigned long j = 0; j < kTapers; j++)
 			{
 				above = ((j << 1) + i);
 				below = ((j << 1) - i) & FFTBinMask;
 				
-                // FIX - why is this swapped?
-                
+				// FIX - why is this swapped?
+				
 				real = FFTData.imagp[above] - FFTData.imagp[below];
 				imag = FFTData.realp[above] - FFTData.realp[below];
 				
 				spectrum[j] += ((real * real) + (imag * imag)) * taperScale; 
 			}
-
-			// Deal wih bins withgut wraparound
-
-			for (unsigned long j = i; j < maxBin; j++)
+		}
+		
+		// Deal with bins without wraparound directly for a few tapers (splitting the data costs more than it saves)
+		
+		if (kTapers < kSplitTapers)
+		{
+			for (unsigned long i = 1; i <= kTapers; i++)
 			{
-				above = ((j << 1) + i);
-				below = ((j << 1) - i);
+				weight = (1.0 - ((i - 1) * (i - 1)) / (double) (kTapers * kTapers));
+				taperScale = weight * scale  * normFactor;
 				
-				real = FFTData.imagp[above] - FFTData.imagp[below];
-				imag = FFTData.realp[above] - FFTData.realp[below];
+				for (unsigned long j = kTapers; j < maxBin; j++)
+				{
+					above = ((j << 1) + i);
+					below = ((j << 1) - i);
+					
+					real = FFTData.imagp[above] - FFTData.imagp[below];
+					imag = FFTData.realp[above] - FFTData.realp[below];
+					
+					spectrum[j] += ((real * real) + (imag * imag)) * taperScale; 
+				}
+			}
+		}
+		else
+		{
+			// Split the FFT data into even and odd bins (so that each taper reads contiguous data for successive output bins)
+			
+			unsigned long splitSize = std::min(FFTSize, maxBin + (kTapers >> 1) + 1);
+			
+			for (unsigned long j = 0; j < splitSize; j++)
+			{
+				mRealEven[j] = FFTData.realp[j << 1];
+				mRealOdd[j] = FFTData.realp[(j << 1) + 1];
+				mImagEven[j] = FFTData.imagp[j << 1];
+				mImagOdd[j] = FFTData.imagp[(j << 1) + 1];
+			}
+			
+			// Deal with bins without wraparound in tiles (all tapers are accumulated for a tile whilst it is in cache)
+			// Bins 2j + i and 2j - i are both even or both odd, so they are at j + i / 2 and j - (i + 1) / 2 of the same split arrays
+			
+			for (unsigned long tile = kTapers; tile < maxBin; tile += kTileSize)
+			{
+				unsigned long tileSize = (maxBin - tile) < kTileSize ? (maxBin - tile) : kTileSize;
 				
-				spectrum[j] += ((real * real) + (imag * imag)) * taperScale; 
+				for (unsigned long i = 1; i <= kTapers; i++)
+				{
+					unsigned long aboveOffset = tile + (i >> 1);
+					unsigned long belowOffset = tile - ((i + 1) >> 1);
+					
+					weight = (1.0 - ((i - 1) * (i - 1)) / (double) (kTapers * kTapers));
+					taperScale = weight * scale  * normFactor;
+					
+					if (i & 1)
+						HISSTools_SIMD::differencePower(spectrum + tile, mImagOdd + aboveOffset, mImagOdd + belowOffset, mRealOdd + aboveOffset, mRealOdd + belowOffset, taperScale, tileSize);
+					else
+						HISSTools_SIMD::differencePower(spectrum + tile, mImagEven + aboveOffset, mImagEven + belowOffset, mRealEven + aboveOffset, mRealEven + belowOffset, taperScale, tileSize);
+				}
 			}
 		}
 					
@@ -252,6 +320,21 @@ public:
 		return TRUE;
 	}
 
+private:
+	
+	// Bins per tile for taper accumulation (and the number of tapers from which the FFT data is split)
+	
+	static const unsigned long kTileSize = 256;
+	static const unsigned long kSplitTapers = 4;
+	
+	// Split FFT data and tapers per bin (for adaption)
+	
+	double *mSplitData;
+	double *mRealEven;
+	double *mRealOdd;
+	double *mImagEven;
+	double *mImagOdd;
+	double *mTapers;
 };
 
 #endif
\ No newline at end of file
@@ -3,117 +3,527 @@
 #ifndef __HISSTOOLS_OLA__
 #define __HISSTOOLS_OLA__
 
+#include <cassert>
+#include "HISSTools_SIMD.hpp"
+#include "HISSTools_Mirrored_Memory.hpp"
+#include "HISSTools_Async_Frames.hpp"
+#include "../HISSTools_Utility/HISSTools_ThreadSafety.hpp"
 
-class HISSTools_OLA {
+
+// Templated on sample type (see the typedefs at the end of the file)
+
+template <class T>
+class HISSTools_OLA_T {
+	
+	// Parameters are handed from setParams() to the audio thread as a single snapshot
+	// Resets are requested by incrementing a count, so that a reset is never lost when it is followed by another write
+	// The count is incremented and published under a single lock, so the audio thread never sees it go backwards
+	
+	struct Params
+	{
+		Params() : mFrameSize(0), mHopSize(0), mHopOffset(0), mResetCount(0) {}
+		
+		unsigned long mFrameSize;
+		unsigned long mHopSize;
+		unsigned long mHopOffset;
+		unsigned long mResetCount;
+	};
 	
 public:
 	
-	HISSTools_OLA(unsigned long maxFrameSize, unsigned long maxChans)
+	// Frame or hop size changes either reset the processing or crossfade from the old stream to the new one over a frame
+	// When crossfading the old stream keeps running until the new stream has built up (frameSize - hopSize) and faded in (frameSize)
+	// Both streams call process() during this time, each with its own frame size
+	
+	enum ResizeMode {kResizeReset, kResizeCrossfade};
+	
+	HISSTools_OLA_T(unsigned long maxFrameSize, unsigned long maxChans)
 	{		
-		bool success = TRUE;
-		
 		maxFrameSize = (maxFrameSize < 2) ? 2 : maxFrameSize;
 
 		maxChans = (maxChans < 1) ? 1 : maxChans;
 		maxChans = (maxChans > 256) ? 256 : maxChans;
 		mMaxChans = maxChans;
 		
-		// Allocate individual channel pointers
+		// All rings are of the maximum frame size (so the current frame size can change without relayout)
+		// Input rings are followed by a second copy so frames can be read contiguously (mirrored in virtual memory where possible)
 		
-		for (unsigned long i = 0; i < mMaxChans; i++)
+		mInputMemory = new HISSTools_Mirrored_Memory<T>(maxFrameSize, mMaxChans);
+		mMirrored = mInputMemory->isMirrored();
+		
+		// Allocate a single aligned slab - all output buffers, then all fade buffers, then all frame buffers
+		// Each channel's region is rounded up to the alignment, so every buffer starts on a cache line
+		
+		unsigned long bufferStride = HISSTools_SIMD::alignedSize(maxFrameSize, sizeof(T));
+		
+		mSlab = HISSTools_SIMD::allocate<T>(bufferStride * 3 * mMaxChans);
+		
+		for (unsigned long i = 0; mSlab && i < mMaxChans; i++)
 		{
-			mInputBuffers[i] = new double[maxFrameSize * 2];
-			mOutputBuffers[i] = new double[maxFrameSize];
-			mFrameBuffers[i] = new double[maxFrameSize];
+			mInputBuffers[i] = mInputMemory->getRing(i);
+			mOutputBuffers[i] = mSlab + (i * bufferStride);
+			mFadeBuffers[i] = mSlab + ((mMaxChans + i) * bufferStride);
+			mFrameBuffers[i] = mSlab + ((mMaxChans * 2 + i) * bufferStride);
 		}
 		
-		for (unsigned long  i = 0; i < mMaxChans; i++)
-			if (!mInputBuffers[i] || !mOutputBuffers[i] || !mFrameBuffers[i])
-				success = FALSE;
+		mMaxFrameSize = (mSlab && mInputMemory->isValid()) ? maxFrameSize : 0;
+		mFrameSize = 0;
+		mHopSize = 0;
+		mResetCount = 0;
+		mRequestedResets = 0;
+		mRequestedHopSize = 0;
+		mResizeMode = kResizeReset;
+		mAsync = NULL;
+		mAsyncFIFO = NULL;
+		mAsyncLatency = 0;
+		mAsyncCount = 0;
+		mAsyncRead = 0;
+		mOverruns = 0;
+		mPool = NULL;
+		mStaggerGroups = 1;
+		mStaggerLayout = 0;
 		
-		mMaxFrameSize = (success == TRUE) ? maxFrameSize : 0;
+		reset();
 	
 		setParams(maxFrameSize, maxFrameSize / 2, TRUE);
 	}
 		
 	
-	~HISSTools_OLA()
+	~HISSTools_OLA_T()
 	{		
-		// Delete individual channel pointers
-
-		for (unsigned long i = 0; i < mMaxChans; i++) 
-		{
-			delete[] mInputBuffers[i];
-			delete[] mOutputBuffers[i];
-			delete[] mFrameBuffers[i];
-		}
+		// Derived classes using async mode must call setAsync(FALSE) in their own destructor
+		// The worker may otherwise call process() on a partially destroyed object (so it cannot be stopped safely here)
+		
+		assert(!mAsync && "call setAsync(FALSE) in the destructor of the derived class");
+		delete mAsync;
+		delete[] mAsyncFIFO;
+		
+		HISSTools_SIMD::deallocate(mSlab);
+		delete mInputMemory;
 	}
 	
 	
 private:
 	
-	void reset(unsigned long frameSize)
+	void reset()
+	{
+		// Nothing is cleared - instead the input history and output are tracked as valid or not, and invalid data is read as zeros
+		
+		mInputValid = 0;
+		mOutputValid = FALSE;
+		mFadeFrameSize = 0;
+		mFadeHopSize = 0;
+		mFadeHopPointer = 0;
+		mFadeGroups = 1;
+		mFadeDelay = 0;
+		mFadeLength = 0;
+		mFadePosition = 0;
+		
+		resetGroups();
+		
+		// Frames in flight are no longer wanted
+		
+		for (; mAsyncCount; mAsyncCount--, mAsyncRead = (mAsyncRead + 1) % mAsyncLatency)
+			if (mAsyncFIFO[mAsyncRead] >= 0)
+				mAsync->abandon(mAsyncFIFO[mAsyncRead]);
+	}
+	
+	
+	void resetGroups()
 	{
 		for (unsigned long i = 0; i < mMaxChans; i++)
+			mGroupValid[i] = FALSE;
+		
+		mValidGroups = 0;
+	}
+	
+	
+	void asyncFrame(unsigned long IOPointer, unsigned long frameSize, unsigned long hopSize, unsigned long nChans, bool multichannel)
+	{
+		// Collect the frame submitted mAsyncLatency hops ago (a missing frame is written as silence)
+		
+		if (mAsyncCount == mAsyncLatency)
+		{
+			long slot = mAsyncFIFO[mAsyncRead];
+			
+			mAsyncRead = (mAsyncRead + 1) % mAsyncLatency;
+			mAsyncCount--;
+			
+			if (slot >= 0 && mAsync->isDone(slot))
+			{
+				typename HISSTools_Async_Frames<T>::Slot &asyncSlot = mAsync->getSlot(slot);
+				
+				for (unsigned long j = 0; j < nChans; j++)
+					writeFrameChannel(mOutputBuffers[j], asyncSlot.mFrames[j], IOPointer, frameSize, mOutputValid ? frameSize - hopSize : 0);
+				
+				mAsync->release(slot);
+				mOutputValid = TRUE;
+			}
+			else 
+			{
+				if (slot >= 0)
+				{
+					mAsync->abandon(slot);
+					mOverruns++;
+				}
+				
+				if (mOutputValid)
+				{
+					for (unsigned long j = 0; j < frameSize; j++)
+						mFrameBuffers[0][j] = 0.;
+					
+					for (unsigned long j = 0; j < nChans; j++)
+						writeFrameChannel(mOutputBuffers[j], mFrameBuffers[0], IOPointer, frameSize, frameSize - hopSize);
+				}
+			}
+		}
+		
+		// Submit the current frame (or drop it if the worker is behind)
+		
+		long slot = mAsync->acquire();
+		
+		if (slot >= 0)
+		{
+			typename HISSTools_Async_Frames<T>::Slot &asyncSlot = mAsync->getSlot(slot);
+			
+			for (unsigned long j = 0; j < nChans; j++)
+				readFrameChannel(asyncSlot.mFrames[j], mInputBuffers[j], IOPointer, frameSize);
+			
+			asyncSlot.mFrameSize = frameSize;
+			asyncSlot.mNChans = nChans;
+			asyncSlot.mMultichannel = multichannel;
+			
+			mAsync->submit(slot);
+		}
+		else
+			mOverruns++;
+		
+		mAsyncFIFO[(mAsyncRead + mAsyncCount++) % mAsyncLatency] = slot;
+	}
+	
+	
+	// Per-channel frame processing (run directly or as tasks on the worker pool)
+	
+	struct ChannelBatch
+	{
+		HISSTools_OLA_T *mOwner;
+		T **mOutputBuffers;
+		unsigned long mIOPointer;
+		unsigned long mFrameSize;
+		unsigned long mOverlapSize;
+		unsigned long mFirstChan;
+	};
+	
+	static void channelTask(void *context, unsigned long task)
+	{
+		ChannelBatch *batch = static_cast<ChannelBatch *>(context);
+		HISSTools_OLA_T *owner = batch->mOwner;
+		unsigned long chan = batch->mFirstChan + task;
+		
+		owner->readFrameChannel(owner->mFrameBuffers[chan], owner->mInputBuffers[chan], batch->mIOPointer, batch->mFrameSize);
+		owner->processChannel(owner->mFrameBuffers[chan], batch->mFrameSize, chan);
+		owner->writeFrameChannel(batch->mOutputBuffers[chan], owner->mFrameBuffers[chan], batch->mIOPointer, batch->mFrameSize, batch->mOverlapSize);
+	}
+	
+	void channelFrames(T **outputBuffers, unsigned long IOPointer, unsigned long frameSize, unsigned long overlapSize, unsigned long firstChan, unsigned long nChans)
+	{
+		ChannelBatch batch = {this, outputBuffers, IOPointer, frameSize, overlapSize, firstChan};
+		
+		if (mPool)
+			mPool->parallelFor(&HISSTools_OLA_T::channelTask, &batch, nChans);
+		else
+		{
+			for (unsigned long i = 0; i < nChans; i++)
+				channelTask(&batch, i);
+		}
+	}
+	
+	
+	// Staggered scheduling - channel group g takes its frames (g / nGroups) of a hop after group 0 (at most one group per sample of the hop)
+	
+	unsigned long staggerGroups(unsigned long hopSize, unsigned long nChans)
+	{
+		unsigned long nGroups = mStaggerGroups < hopSize ? mStaggerGroups : hopSize;
+		
+		return nGroups < nChans ? nGroups : nChans;
+	}
+	
+	
+	unsigned long staggerOffset(unsigned long group, unsigned long nGroups, unsigned long hopSize)
+	{
+		return group ? (group * hopSize) / nGroups : hopSize;
+	}
+	
+	
+	long staggerHopTime(long hopPointer, unsigned long hopSize, unsigned long nGroups)
+	{
+		for (unsigned long g = 1; g < nGroups; g++)
 		{
-			for (unsigned long j = 0; j < frameSize * 2; j++)
-				mInputBuffers[i][j] = 0.;
+			long offset = staggerOffset(g, nGroups, hopSize);
 			
-			for (unsigned long j = 0; j < frameSize; j++)
-				mOutputBuffers[i][j] = 0.;
+			if (offset > hopPointer)
+				return offset - hopPointer;
 		}
+		
+		return hopSize - hopPointer;
 	}
 	
 	
-	void writeFrameChannel(double *outputBuffer, double *frameBuffer, long IOPointer, unsigned long frameSize, unsigned long hopSize)
+	bool staggerFrames(unsigned long IOPointer, long hopPointer, unsigned long frameSize, unsigned long hopSize, unsigned long nChans)
 	{
-		long testLength;
-		long i;
+		unsigned long nGroups = staggerGroups(hopSize, nChans);
+		bool processedFrames = FALSE;
+		
+		// Group validity is only tracked for one grouping (a different channel count or hop size may change it)
+		
+		if (nGroups != mStaggerLayout)
+		{
+			resetGroups();
+			mStaggerLayout = nGroups;
+		}
+		
+		for (unsigned long g = 0; g < nGroups; g++)
+		{
+			long offset = staggerOffset(g, nGroups, hopSize);
+			
+			if (g ? hopPointer != offset : hopPointer < offset)
+				continue;
+			
+			unsigned long firstChan = (g * nChans) / nGroups;
+			unsigned long groupChans = (((g + 1) * nChans) / nGroups) - firstChan;
+			
+			channelFrames(mOutputBuffers, IOPointer, frameSize, (mOutputValid || mGroupValid[g]) ? frameSize - hopSize : 0, firstChan, groupChans);
+			processedFrames = TRUE;
+			
+			// Output is only read once every group has been written (valid output is never made invalid here)
+			
+			if (!mGroupValid[g])
+			{
+				mGroupValid[g] = TRUE;
 				
-		// Overlappoing part
+				if (++mValidGroups == nGroups)
+					mOutputValid = TRUE;
+			}
+		}
+		
+		return processedFrames;
+	}
+	
+	
+	// Number of groups a stream is staggered into (one when not staggered)
+	
+	unsigned long streamGroups(unsigned long hopSize, unsigned long nChans)
+	{
+		return (mStaggerGroups > 1 && !mAsync && nChans > 1) ? staggerGroups(hopSize, nChans) : 1;
+	}
+	
+	
+	// The fading stream keeps its grouping, so each group's frames continue on that group's hop grid
+	
+	bool fadeFrames(unsigned long IOPointer, unsigned long nChans)
+	{
+		unsigned long nGroups = mFadeGroups < nChans ? mFadeGroups : nChans;
+		unsigned long overlapSize = mFadeFrameSize - mFadeHopSize;
+		bool processedFrames = FALSE;
+		
+		for (unsigned long g = 0; g < nGroups; g++)
+		{
+			unsigned long offset = staggerOffset(g, nGroups, mFadeHopSize);
+			
+			if (g ? mFadeHopPointer != offset : mFadeHopPointer < offset)
+				continue;
+			
+			unsigned long firstChan = (g * nChans) / nGroups;
+			unsigned long groupChans = (((g + 1) * nChans) / nGroups) - firstChan;
+			
+			channelFrames(mFadeBuffers, IOPointer, mFadeFrameSize, overlapSize, firstChan, groupChans);
+			processedFrames = TRUE;
+		}
 		
-		IOPointer = IOPointer >= frameSize ? 0 : IOPointer;
+		mFadeHopPointer = mFadeHopPointer >= mFadeHopSize ? 0 : mFadeHopPointer;
 		
-		for (i = 0, testLength = frameSize - IOPointer; i < frameSize - hopSize && i < testLength; i++)
-			outputBuffer[IOPointer++] += *frameBuffer++;
+		return processedFrames;
+	}
+	
+	
+	void processSlot(typename HISSTools_Async_Frames<T>::Slot &slot)
+	{
+		if (slot.mMultichannel)
+			process(slot.mFrames, slot.mFrameSize, slot.mNChans);
+		else
+			process(slot.mFrames[0], slot.mFrameSize);
+	}
+	
+	
+	void startCrossfade(unsigned long frameSize, unsigned long hopSize, unsigned long nChans)
+	{
+		// With no output yet there is nothing to fade from
+		
+		mFadeLength = 0;
+		mFadePosition = 0;
+		
+		if (!mOutputValid)
+			return;
+		
+		// The current stream becomes the fading stream (any fade already in progress is dropped)
+		
+		for (unsigned long i = 0; i < mMaxChans; i++)
+			std::swap(mOutputBuffers[i], mFadeBuffers[i]);
+		
+		mFadeFrameSize = mFrameSize;
+		mFadeHopSize = mHopSize <= mFrameSize ? mHopSize : mFrameSize;
+		mFadeHopPointer = mBlockHopPointer;
+		mFadeGroups = streamGroups(mFadeHopSize, nChans);
+		
+		// Fade in the new stream once every sample it outputs is the sum of a full set of overlapping frames
+		// When staggered the last group takes its first frame latest, so the delay includes that group's offset
+		
+		unsigned long nGroups = streamGroups(hopSize, nChans);
+		
+		mFadeDelay = frameSize - hopSize + (nGroups > 1 ? staggerOffset(nGroups - 1, nGroups, hopSize) : 0);
+		mFadeLength = frameSize;
+		mOutputValid = FALSE;
+		
+		resetGroups();
+	}
+	
+	
+	void advanceFade(unsigned long size)
+	{
+		mFadePosition += size;
+		mFadeHopPointer += size;
+		
+		if (mFadePosition >= mFadeDelay + mFadeLength)
+			mFadeLength = mFadePosition = 0;
+	}
+	
+	
+	void advanceInput(unsigned long size)
+	{
+		mInputValid = (mInputValid + size) < mMaxFrameSize ? mInputValid + size : mMaxFrameSize;
+	}
+	
+	
+	void readFrameChannel(T *frameBuffer, const T *inputBuffer, unsigned long IOPointer, unsigned long frameSize)
+	{
+		// Read the most recent frameSize samples (zeros before the start of the valid history)
+		
+		unsigned long validSize = mInputValid < frameSize ? mInputValid : frameSize;
+		
+		for (unsigned long i = 0; i < frameSize - validSize; i++)
+			frameBuffer[i] = 0.;
+		
+		HISSTools_SIMD::copy(frameBuffer + frameSize - validSize, inputBuffer + IOPointer + mMaxFrameSize - validSize, validSize);
+	}
+	
+	
+	void readOutputChannel(T *output, unsigned long chan, unsigned long IOPointer, unsigned long size, unsigned long stride = 1)
+	{
+		const T *outputBuffer = mOutputBuffers[chan] + IOPointer;
+		const T *fadeBuffer = mFadeBuffers[chan] + IOPointer;
 		
-		IOPointer = IOPointer >= frameSize ? 0 : IOPointer;
+		unsigned long fadeRemain = mFadeLength ? (mFadeDelay + mFadeLength) - mFadePosition : 0;
+		unsigned long fadeSize = fadeRemain < size ? fadeRemain : size;
+		unsigned long i = 0;
 		
-		for (; i < frameSize - hopSize; i++)
-			outputBuffer[IOPointer++] += *frameBuffer++;
+		// Crossfade from the previous stream (the current stream is silent until its first frame is written)
+		
+		for (; i < fadeSize; i++)
+		{
+			unsigned long position = mFadePosition + i;
+			T gain = position < mFadeDelay ? 0. : (T) (position - mFadeDelay + 1) / (T) (mFadeLength + 1);
+			T current = mOutputValid ? outputBuffer[i] : 0.;
 			
-		// Non-overlapping part
+			output[i * stride] = (current * gain) + (fadeBuffer[i] * (1. - gain));
+		}
 		
-		IOPointer = IOPointer >= frameSize ? 0 : IOPointer;			
-
-		for (i = 0, testLength = frameSize - IOPointer; i < hopSize && i < testLength; i++)
-			outputBuffer[IOPointer++] = *frameBuffer++;
-
-		IOPointer = IOPointer >= frameSize ? 0 : IOPointer;			
-
-		for (; i < hopSize; i++)
-			outputBuffer[IOPointer++] = *frameBuffer++;
+		// Current stream
+		
+		if (mOutputValid && stride == 1)
+			HISSTools_SIMD::copy(output + i, outputBuffer + i, size - i);
+		else
+		{
+			for (; i < size; i++)
+				output[i * stride] = mOutputValid ? outputBuffer[i] : 0.;
+		}
 	}
 	
 	
-	void update()
+	void writeFrameChannel(T *outputBuffer, T *frameBuffer, unsigned long IOPointer, unsigned long frameSize, unsigned long overlapSize)
+	{
+		unsigned long bufferSize = mMaxFrameSize;
+		
+		IOPointer = IOPointer >= bufferSize ? 0 : IOPointer;
+		
+		// Calculate loop sizes
+		
+		unsigned long bufferRemain = bufferSize - IOPointer;
+		unsigned long loop1 = (bufferRemain < overlapSize) ? bufferRemain : overlapSize;
+		unsigned long loop2 = (bufferRemain < frameSize) ? bufferRemain : frameSize;
+		unsigned long loop3 = (overlapSize > loop2) ? overlapSize - loop2 : 0UL;
+		
+		// Overlapping part (not wrapped)
+		
+		HISSTools_SIMD::accumulate(outputBuffer + IOPointer, frameBuffer, loop1);
+		
+		// Non-overlapping part (not wrapped)
+		
+		HISSTools_SIMD::copy(outputBuffer + IOPointer + loop1, frameBuffer + loop1, loop2 - loop1);
+		
+		// Overlapping part (wrapped)
+		
+		HISSTools_SIMD::accumulate(outputBuffer, frameBuffer + loop2, loop3);
+		
+		// Non-overlapping part (wrapped)
+		
+		HISSTools_SIMD::copy(outputBuffer + loop3, frameBuffer + loop2 + loop3, frameSize - (loop2 + loop3));
+	}
+	
+	
+	void writeInputChannel(T *inputBuffer, const T *input, unsigned long IOPointer, unsigned long size)
+	{
+		// Write to the ring and (unless the memory is mirrored) to its second copy
+		
+		HISSTools_SIMD::copy(inputBuffer + IOPointer, input, size);
+		
+		if (!mMirrored)
+			HISSTools_SIMD::copy(inputBuffer + IOPointer + mMaxFrameSize, inputBuffer + IOPointer, size);
+	}
+	
+	
+	void update(unsigned long nChans)
 	{
-		// FIX - Threadsafety!!
 		// FIX - do this so we can keep the last values coming in??
-        
-		if (mReset == TRUE || mNewFrameSize != mFrameSize || mNewHopSize != mHopSize)
+		
+		Params params;
+		
+		// Read the latest complete set of parameters (wait-free)
+		
+		mParams.read(params);
+		
+		if (params.mResetCount != mResetCount || params.mFrameSize != mFrameSize || params.mHopSize != mHopSize)
 		{	
-			// Reset
-			
-			reset(mNewFrameSize);
+			if (params.mResetCount == mResetCount && mResizeMode == kResizeCrossfade && !mAsync)
+			{
+				// Crossfade (keeping the input history and IO position, and taking a frame immediately)
+				
+				startCrossfade(params.mFrameSize, params.mHopSize, nChans);
+				mBlockHopPointer = params.mHopSize;
+			}
+			else
+			{
+				// Reset
+				
+				reset();
+				mBlockIOPointer = 0;
+				mBlockHopPointer = params.mHopOffset;
+			}
 			
 			// Update parameters
 			
-			mFrameSize = mNewFrameSize;
-			mHopSize = mNewHopSize;
-			mBlockIOPointer = 0;
-			mBlockHopPointer = mNewHopOffset;
-			mReset = FALSE;
+			mFrameSize = params.mFrameSize;
+			mHopSize = params.mHopSize;
+			mResetCount = params.mResetCount;
 		}
 	}
 	
@@ -122,6 +532,11 @@ private:
 	{
 		long minTime = hopTime;
 		
+		// The fading stream (if any) also takes frames
+		
+		if (mFadeLength && staggerHopTime(mFadeHopPointer, mFadeHopSize, mFadeGroups) < minTime)
+			minTime = staggerHopTime(mFadeHopPointer, mFadeHopSize, mFadeGroups);
+		
 		if (writeTime < minTime)
 			minTime = writeTime;
 		if (blockTime < minTime)
@@ -133,30 +548,39 @@ private:
 	
 protected:
 	
-	void virtual process(double *ioFrame, unsigned long frameSize)
+	void virtual process(T *ioFrame, unsigned long frameSize)
 	{
 		// This function should be overridden for single channel operation. 
 		// IO is on a single shared buffer
 	}
 	
 	
-	void virtual process(double **ioFrames, unsigned long frameSize, unsigned long nChans)
+	void virtual process(T **ioFrames, unsigned long frameSize, unsigned long nChans)
 	{
 		// This function should be overridden for multichannel operation. 
 		// IO is on a single shared buffer per channel
 	}
 	
 	
+	void virtual processChannel(T *ioFrame, unsigned long frameSize, unsigned long chan)
+	{
+		// This function should be overridden for parallel multichannel operation (it may be called concurrently for different channels).
+		// By default each channel is processed as a single channel frame
+		
+		process(ioFrame, frameSize);
+	}
+	
+	
 public:
 	
-	bool overlapAdd(double *in, double *out, unsigned long nSamps)
+	bool overlapAdd(T *in, T *out, unsigned long nSamps)
 	{
         bool processedFrames = FALSE;
         
-		double *inputBuffer = mInputBuffers[0];
-		double *outputBuffer = mOutputBuffers[0];
-		double *frameBuffer = mFrameBuffers[0];
+		T *inputBuffer = mInputBuffers[0];
+		T *frameBuffer = mFrameBuffers[0];
 				
+		unsigned long bufferSize;
 		unsigned long frameSize;
 		unsigned long hopSize;
 		
@@ -166,46 +590,64 @@ public:
 	
 		// Update parameters
 		
-		update();
+		update(1);
 		
 		// Get parameters
 		
+		bufferSize = mMaxFrameSize;
 		frameSize = mFrameSize;
 		hopSize = mHopSize <= frameSize ? mHopSize : frameSize;
-		IOPointer = mBlockIOPointer >= frameSize ? 0 : mBlockIOPointer;
+		IOPointer = mBlockIOPointer >= bufferSize ? 0 : mBlockIOPointer;
 		hopPointer = mBlockHopPointer;
 		
 		// Loop over vector grabbing frames as appropriate
 
 		for (long i = 0; i < nSamps;)
 		{			
-			// Grab a frame and OLA with processing
+			// Grab a frame (the most recent frameSize samples) and OLA with processing
 
 			if (hopPointer >= hopSize)
 			{
                 processedFrames = TRUE;
                 hopPointer = 0;
                 
-				for (long j = 0; j < frameSize; j++)
-					frameBuffer[j] = inputBuffer[IOPointer + j];
-
-				process(frameBuffer, frameSize);
-				writeFrameChannel(outputBuffer, frameBuffer, IOPointer, frameSize, hopSize);
+				if (mAsync)
+					asyncFrame(IOPointer, frameSize, hopSize, 1, FALSE);
+				else
+				{
+					readFrameChannel(frameBuffer, inputBuffer, IOPointer, frameSize);
+					process(frameBuffer, frameSize);
+					writeFrameChannel(mOutputBuffers[0], frameBuffer, IOPointer, frameSize, mOutputValid ? frameSize - hopSize : 0);
+					
+					mOutputValid = TRUE;
+				}
+			}
+			
+			// Continue the fading stream
+			
+			if (mFadeLength && mFadeHopPointer >= mFadeHopSize)
+			{
+				processedFrames = TRUE;
+				mFadeHopPointer = 0;
+				
+				readFrameChannel(frameBuffer, inputBuffer, IOPointer, mFadeFrameSize);
+				process(frameBuffer, mFadeFrameSize);
+				writeFrameChannel(mFadeBuffers[0], frameBuffer, IOPointer, mFadeFrameSize, mFadeFrameSize - mFadeHopSize);
 			}
 			
 			// Update pointers and check loop size
 
-			IOPointer = IOPointer >= frameSize ? 0 : IOPointer;
-			loopSize = loopMin(hopSize - hopPointer, frameSize - IOPointer, nSamps - i);
+			IOPointer = IOPointer >= bufferSize ? 0 : IOPointer;
+			loopSize = loopMin(hopSize - hopPointer, bufferSize - IOPointer, nSamps - i);
 			
 			// Copy samples in/out
 
-			for (long j = 0; j < loopSize; j++, IOPointer++)
-			{
-				inputBuffer[IOPointer] = inputBuffer[IOPointer + frameSize] = *in++;
-				*out++ = outputBuffer[IOPointer];
-			}
+			writeInputChannel(inputBuffer, in + i, IOPointer, loopSize);
+			readOutputChannel(out + i, 0, IOPointer, loopSize);
+			advanceInput(loopSize);
+			advanceFade(loopSize);
 			
+			IOPointer += loopSize;
 			hopPointer += loopSize;
 			i += loopSize;
 		}
@@ -217,16 +659,21 @@ public:
 	}
 	
 	
-	bool overlapAdd(double **ins, double **outs, unsigned long nSamps, unsigned long nChans)
+private:
+	
+	bool overlapAdd(T **ins, T **outs, const T *interleavedIn, T *interleavedOut, unsigned long nSamps, unsigned long nChans)
 	{
         bool processedFrames = FALSE;
 
+        unsigned long bufferSize;
         unsigned long frameSize;
 		unsigned long hopSize;
 		
 		long IOPointer;
 		long hopPointer;
 		long loopSize;
+		
+		bool stagger;
 
 		// Sanity Check
 
@@ -235,52 +682,130 @@ public:
 			
 		// Update parameters
 		
-		update();
+		update(nChans);
 		
 		// Get parameters
 		
+		bufferSize = mMaxFrameSize;
 		frameSize = mFrameSize;
 		hopSize = mHopSize <= frameSize ? mHopSize : frameSize;
-		IOPointer = mBlockIOPointer >= frameSize ? 0 : mBlockIOPointer;
+		IOPointer = mBlockIOPointer >= bufferSize ? 0 : mBlockIOPointer;
 		hopPointer = mBlockHopPointer;
+		stagger = streamGroups(hopSize, nChans) > 1;
 		
 		// Loop over vector grabbing frames as appropriate
 		
 		for (long i = 0; i < nSamps;)
 		{	
-			// Grab a frame and OLA with processing
+			// Grab a frame (the most recent frameSize samples) and OLA with processing
 			
-			if (hopPointer >= hopSize)
+			if (stagger)
+			{
+				if (staggerFrames(IOPointer, hopPointer, frameSize, hopSize, nChans))
+					processedFrames = TRUE;
+				
+				hopPointer = hopPointer >= hopSize ? 0 : hopPointer;
+			}
+			else if (hopPointer >= hopSize)
 			{
                 processedFrames = TRUE;
                 hopPointer = 0;
                 
-				for (long j = 0; j < nChans; j++)
-					for (long k = 0; k < frameSize; k++)
-						mFrameBuffers[j][k] = mInputBuffers[j][IOPointer + k];
-				
-				process(mFrameBuffers, frameSize, nChans);
+				if (mAsync)
+					asyncFrame(IOPointer, frameSize, hopSize, nChans, TRUE);
+				else if (mPool)
+				{
+					channelFrames(mOutputBuffers, IOPointer, frameSize, mOutputValid ? frameSize - hopSize : 0, 0, nChans);
+					mOutputValid = TRUE;
+				}
+				else
+				{
+					for (long j = 0; j < nChans; j++)
+						readFrameChannel(mFrameBuffers[j], mInputBuffers[j], IOPointer, frameSize);
+					
+					process(mFrameBuffers, frameSize, nChans);
+					
+					for (long j = 0; j < nChans; j++)					
+						writeFrameChannel(mOutputBuffers[j], mFrameBuffers[j], IOPointer, frameSize, mOutputValid ? frameSize - hopSize : 0);
+					
+					mOutputValid = TRUE;
+				}
+			}
+			
+			// Continue the fading stream (per group if it was staggered)
+			
+			if (mFadeLength && mFadeGroups > 1)
+			{
+				if (fadeFrames(IOPointer, nChans))
+					processedFrames = TRUE;
+			}
+			else if (mFadeLength && mFadeHopPointer >= mFadeHopSize)
+			{
+				processedFrames = TRUE;
+				mFadeHopPointer = 0;
 				
-				for (long j = 0; j < nChans; j++)					
-					writeFrameChannel(mOutputBuffers[j], mFrameBuffers[j], IOPointer, frameSize, hopSize);
+				if (mPool)
+					channelFrames(mFadeBuffers, IOPointer, mFadeFrameSize, mFadeFrameSize - mFadeHopSize, 0, nChans);
+				else
+				{
+					for (long j = 0; j < nChans; j++)
+						readFrameChannel(mFrameBuffers[j], mInputBuffers[j], IOPointer, mFadeFrameSize);
+					
+					process(mFrameBuffers, mFadeFrameSize, nChans);
+					
+					for (long j = 0; j < nChans; j++)
+						writeFrameChannel(mFadeBuffers[j], mFrameBuffers[j], IOPointer, mFadeFrameSize, mFadeFrameSize - mFadeHopSize);
+				}
 			}
 			
 			// Update pointers and check loop size
 			
-			IOPointer = IOPointer >= frameSize ? 0 : IOPointer;
-			loopSize = loopMin(hopSize - hopPointer, frameSize - IOPointer, nSamps - i);
+			IOPointer = IOPointer >= bufferSize ? 0 : IOPointer;
+			loopSize = loopMin(stagger ? staggerHopTime(hopPointer, hopSize, staggerGroups(hopSize, nChans)) : hopSize - hopPointer, bufferSize - IOPointer, nSamps - i);
 			
-			// Loop over channels and copy samples in/out
+			// Copy samples in/out (interleaved IO loops channel-inner so the host buffers are read and written with unit stride)
 			
-			for (long j = 0; j < nChans; j++)
+			if (interleavedIn)
+			{
+				const T *in = interleavedIn + (i * nChans);
+				T *out = interleavedOut + (i * nChans);
+				
+				if (mOutputValid && !mFadeLength)
+				{
+					for (long l = IOPointer; l < (IOPointer + loopSize); l++)
+					{
+						for (long j = 0; j < nChans; j++)
+						{
+							mInputBuffers[j][l] = *in++;
+							*out++ = mOutputBuffers[j][l];
+						}
+					}
+				}
+				else
+				{
+					for (long l = IOPointer; l < (IOPointer + loopSize); l++)
+						for (long j = 0; j < nChans; j++)
+							mInputBuffers[j][l] = *in++;
+					
+					for (long j = 0; j < nChans; j++)
+						readOutputChannel(out + j, j, IOPointer, loopSize, nChans);
+				}
+				
+				for (long j = 0; !mMirrored && j < nChans; j++)
+					HISSTools_SIMD::copy(mInputBuffers[j] + IOPointer + bufferSize, mInputBuffers[j] + IOPointer, loopSize);
+			}
+			else
 			{
-				for (long k = i, l = IOPointer; k < (i + loopSize); k++, l++)
+				for (long j = 0; j < nChans; j++)
 				{
-					mInputBuffers[j][l] = mInputBuffers[j][l + frameSize] = ins[j][k];
-					outs[j][k] = mOutputBuffers[j][l];
+					writeInputChannel(mInputBuffers[j], ins[j] + i, IOPointer, loopSize);
+					readOutputChannel(outs[j] + i, j, IOPointer, loopSize);
 				}
 			}
 			
+			advanceInput(loopSize);
+			advanceFade(loopSize);
+			
 			IOPointer += loopSize;
 			hopPointer += loopSize;
 			i += loopSize;
@@ -293,22 +818,123 @@ public:
 	}
 	
 	
+public:
+	
+	bool overlapAdd(T **ins, T **outs, unsigned long nSamps, unsigned long nChans)
+	{
+		return overlapAdd(ins, outs, NULL, NULL, nSamps, nChans);
+	}
+	
+	
+	// Interleaved IO (nSamps frames of nChans samples each)
+	
+	bool overlapAddInterleaved(const T *in, T *out, unsigned long nSamps, unsigned long nChans)
+	{
+		return overlapAdd(NULL, NULL, in, out, nSamps, nChans);
+	}
+	
+	
+	void setResizeMode(ResizeMode mode)
+	{
+		mResizeMode = mode;
+	}
+	
+	
+	// Asynchronous mode - frames are processed in order on a worker thread (process() is called on that thread)
+	// Each frame's output is collected latencyHops hops later, adding a fixed latency (getAsyncLatency()) to the output
+	// A frame that is not ready in time is output as silence (and counted as an overrun) - resizes always reset in this mode
+	// Not threadsafe - call when not processing (derived classes must switch async mode off before they are destroyed)
+	
+	void setAsync(bool async, unsigned long latencyHops = 2)
+	{
+		delete mAsync;
+		delete[] mAsyncFIFO;
+		
+		mAsync = NULL;
+		mAsyncFIFO = NULL;
+		mAsyncLatency = 0;
+		mAsyncCount = 0;
+		mAsyncRead = 0;
+		
+		if (async == TRUE && mMaxFrameSize)
+		{
+			mAsyncLatency = latencyHops < 1 ? 1 : latencyHops;
+			mAsyncFIFO = new long[mAsyncLatency];
+			mAsync = new HISSTools_Async_Frames<T>(mMaxFrameSize, mMaxChans, mAsyncLatency + 2, std::bind(&HISSTools_OLA_T::processSlot, this, std::placeholders::_1));
+		}
+		
+		// Output written before the switch is no longer continued by new frames
+		
+		reset();
+	}
+	
+	
+	// Parallel mode - multichannel frames are processed per channel (with processChannel()) as tasks on a shared worker pool
+	// The audio thread runs tasks too, and runs them all itself if the pool is in use elsewhere (pass NULL to switch off)
+	// Not threadsafe - call when not processing (async mode takes precedence)
+	
+	void setParallel(HISSTools_WorkerPool *pool)
+	{
+		mPool = pool;
+	}
+	
+	
+	// Staggered mode - multichannel frames are processed per channel (with processChannel()) in nGroups groups of channels
+	// Group g takes its frames (g / nGroups) of a hop after the first group, spreading frame work evenly across the hop
+	// Output is only read once every group has taken a frame after a reset (pass 1 to switch off)
+	// Changing the number of groups resets the output (which restarts from silence) - channel count changes while processing do not
+	// Not threadsafe - call when not processing (async mode takes precedence, but parallel mode may be used with staggering)
+	
+	void setStagger(unsigned long nGroups)
+	{
+		mStaggerGroups = nGroups < 1 ? 1 : (nGroups > mMaxChans ? mMaxChans : nGroups);
+		reset();
+	}
+	
+	
+	// Extra latency in samples for the most recently requested hop size (zero when not in async mode)
+	// May be called from any thread (the value is from setParams(), so it is correct before the audio thread applies the change)
+	
+	unsigned long getAsyncLatency() const
+	{
+		return mAsyncLatency * mRequestedHopSize.load(std::memory_order_relaxed);
+	}
+	
+	
+	unsigned long getOverruns() const
+	{
+		return mOverruns;
+	}
+	
+	
+	// Threadsafe (may be called from any thread - the audio thread never blocks or sees a partial update)
+	
 	void setParams(unsigned long frameSize, unsigned long hopSize, bool reset = FALSE, unsigned long hopOffset = 0)
 	{
-		mNewFrameSize = frameSize < mMaxFrameSize ? (frameSize ? frameSize : 1) : mMaxFrameSize;
-		mNewHopSize = hopSize <= mNewFrameSize ? (hopSize ? hopSize : 1) : mNewFrameSize;
-		mNewHopOffset = hopOffset > mNewHopSize ? mNewHopSize : hopOffset;
-		mReset = reset;
+		Params params;
+		
+		params.mFrameSize = frameSize < mMaxFrameSize ? (frameSize ? frameSize : 1) : mMaxFrameSize;
+		params.mHopSize = hopSize <= params.mFrameSize ? (hopSize ? hopSize : 1) : params.mFrameSize;
+		params.mHopOffset = hopOffset > params.mHopSize ? params.mHopSize : hopOffset;
+		
+		mResetLock.acquire();
+		params.mResetCount = reset == TRUE ? ++mRequestedResets : mRequestedResets;
+		mRequestedHopSize.store(params.mHopSize, std::memory_order_relaxed);
+		mParams.write(params);
+		mResetLock.release();
 	}
 	
 	
 private:
 	
-	// Data
+	// Data (input rings are held in mirrored memory, other buffers are pointers into a single slab)
 	
-	double *mInputBuffers[256];
-	double *mOutputBuffers[256];
-	double *mFrameBuffers[256];
+	HISSTools_Mirrored_Memory<T> *mInputMemory;
+	T *mSlab;
+	T *mInputBuffers[256];
+	T *mOutputBuffers[256];
+	T *mFadeBuffers[256];
+	T *mFrameBuffers[256];
 	
 	// Pointers
 	
@@ -327,14 +953,61 @@ private:
 	
 	// Update Parameters
 	
-	unsigned long mNewFrameSize;
-	unsigned long mNewHopSize;
-	unsigned long mNewHopOffset;
+	HISSTools_TripleBuffer<Params> mParams;
 	
 	// Reset
 	
-	bool mReset;
+	HISSTools_SpinLock mResetLock;
+	unsigned long mRequestedResets;
+	unsigned long mResetCount;
+	
+	// Most recently requested hop size (for getAsyncLatency())
+	
+	std::atomic<unsigned long> mRequestedHopSize;
+	
+	// Validity (samples of input history / whether the current stream has output) and Crossfading
+	
+	unsigned long mInputValid;
+	bool mOutputValid;
+	
+	unsigned long mFadeFrameSize;
+	unsigned long mFadeHopSize;
+	unsigned long mFadeHopPointer;
+	unsigned long mFadeGroups;
+	unsigned long mFadeDelay;
+	unsigned long mFadeLength;
+	unsigned long mFadePosition;
+	
+	std::atomic<int> mResizeMode;
+	
+	// Asynchronous Processing (slots in flight are held in submission order)
+	
+	HISSTools_Async_Frames<T> *mAsync;
+	long *mAsyncFIFO;
+	unsigned long mAsyncLatency;
+	unsigned long mAsyncCount;
+	unsigned long mAsyncRead;
+	std::atomic<unsigned long> mOverruns;
+	
+	// Parallel Processing
+	
+	HISSTools_WorkerPool *mPool;
+	
+	// Staggered Processing
+	
+	unsigned long mStaggerGroups;
+	unsigned long mStaggerLayout;
+	unsigned long mValidGroups;
+	bool mGroupValid[256];
+	
+	// Input Memory Mode
+	
+	bool mMirrored;
 };
 
 
+typedef HISSTools_OLA_T<double> HISSTools_OLA;
+typedef HISSTools_OLA_T<float> HISSTools_OLA_Float;
+
+
 #endif
\ No newline at end of file
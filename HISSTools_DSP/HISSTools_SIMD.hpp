@@ -0,0 +1,1120 @@
+
+#ifndef __HISSTOOLS_SIMD__
+#define __HISSTOOLS_SIMD__
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+// Platform detection (x86 has SSE2 as a baseline on all 64 bit targets - AVX2 is checked at runtime)
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HISSTOOLS_SIMD_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define HISSTOOLS_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+// Allow AVX2 code to be compiled without enabling AVX2 for the whole translation unit
+
+#if defined(HISSTOOLS_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#define HISSTOOLS_TARGET_AVX2 __attribute__((target("avx2")))
+#define HISSTOOLS_TARGET_F16C __attribute__((target("avx,f16c")))
+#else
+#define HISSTOOLS_TARGET_AVX2
+#define HISSTOOLS_TARGET_F16C
+#endif
+
+
+class HISSTools_SIMD
+{
+
+public:
+
+	enum SIMDType {kScalar, kSSE2, kAVX2, kNEON};
+
+	// The best type for this machine (detected once, on first call)
+
+	static SIMDType getType()
+	{
+		static const SIMDType type = detectType();
+
+		return type;
+	}
+
+	// Aligned memory (aligned for the widest vector type and to cache lines) - sizes are in elements
+
+	static const unsigned long kAlignment = 64;
+
+	static unsigned long alignedSize(unsigned long size, unsigned long elementSize)
+	{
+		unsigned long alignElements = kAlignment / elementSize;
+
+		return ((size + alignElements - 1) / alignElements) * alignElements;
+	}
+
+	template <class T>
+	static T *allocate(unsigned long size)
+	{
+		void *ptr = NULL;
+		size_t bytes = alignedSize(size ? size : 1, sizeof(T)) * sizeof(T);
+
+#if defined(_WIN32)
+		ptr = _aligned_malloc(bytes, kAlignment);
+#else
+		if (posix_memalign(&ptr, kAlignment, bytes))
+			ptr = NULL;
+#endif
+		return static_cast<T *>(ptr);
+	}
+
+	template <class T>
+	static void deallocate(T *ptr)
+	{
+#if defined(_WIN32)
+		_aligned_free(ptr);
+#else
+		free(ptr);
+#endif
+	}
+
+	// Copy (libc memcpy is already vectorised on all relevant platforms, so is used for all types)
+
+	template <class T>
+	static void copy(T *out, const T *in, unsigned long size)
+	{
+		if (size)
+			memcpy(out, in, size * sizeof(T));
+	}
+
+	// Accumulate (out += in)
+
+	template <class T>
+	static void accumulate(T *out, const T *in, unsigned long size)
+	{
+		accumulate(out, in, size, getType());
+	}
+
+	template <class T>
+	static void accumulate(T *out, const T *in, unsigned long size, SIMDType type)
+	{
+		unsigned long i = 0;
+
+		switch (type)
+		{
+			case kAVX2:		i = accumulateAVX2(out, in, size);		break;
+			case kSSE2:		i = accumulateSSE2(out, in, size);		break;
+			case kNEON:		i = accumulateNEON(out, in, size);		break;
+			case kScalar:											break;
+		}
+
+		// Scalar loop (remainder, or whole loop for scalar type)
+
+		for (; i < size; i++)
+			out[i] += in[i];
+	}
+
+	// Multiply (out = in1 * in2 - out may be either input)
+
+	template <class T>
+	static void multiply(T *out, const T *in1, const T *in2, unsigned long size)
+	{
+		unsigned long i = 0;
+
+		switch (getType())
+		{
+			case kAVX2:		i = multiplyAVX2(out, in1, in2, size);		break;
+			case kSSE2:		i = multiplySSE2(out, in1, in2, size);		break;
+			case kNEON:		i = multiplyNEON(out, in1, in2, size);		break;
+			case kScalar:												break;
+		}
+
+		for (; i < size; i++)
+			out[i] = in1[i] * in2[i];
+	}
+
+	// Scale (out = in * gain - out may be in)
+
+	static void scale(double *out, const double *in, double gain, unsigned long size)
+	{
+		unsigned long i = 0;
+
+		switch (getType())
+		{
+			case kAVX2:		i = scaleAVX2(out, in, gain, size);		break;
+			case kSSE2:		i = scaleSSE2(out, in, gain, size);		break;
+			case kNEON:		i = scaleNEON(out, in, gain, size);		break;
+			case kScalar:											break;
+		}
+
+		for (; i < size; i++)
+			out[i] = in[i] * gain;
+	}
+
+	// Lifting step (out += (in1 * gain1) + (in2 * gain2) - the inputs must not overlap out)
+
+	static void lift(double *out, const double *in1, const double *in2, double gain1, double gain2, unsigned long size)
+	{
+		unsigned long i = 0;
+
+		switch (getType())
+		{
+			case kAVX2:		i = liftAVX2(out, in1, in2, gain1, gain2, size);		break;
+			case kSSE2:		i = liftSSE2(out, in1, in2, gain1, gain2, size);		break;
+			case kNEON:		i = liftNEON(out, in1, in2, gain1, gain2, size);		break;
+			case kScalar:															break;
+		}
+
+		for (; i < size; i++)
+			out[i] += (in1[i] * gain1) + (in2[i] * gain2);
+	}
+
+	// Power of a split complex difference (out += ((real1 - real2)^2 + (imag1 - imag2)^2) * gain - the inputs must not overlap out)
+
+	static void differencePower(double *out, const double *real1, const double *real2, const double *imag1, const double *imag2, double gain, unsigned long size)
+	{
+		unsigned long i = 0;
+
+		switch (getType())
+		{
+			case kAVX2:		i = differencePowerAVX2(out, real1, real2, imag1, imag2, gain, size);		break;
+			case kSSE2:		i = differencePowerSSE2(out, real1, real2, imag1, imag2, gain, size);		break;
+			case kNEON:		i = differencePowerNEON(out, real1, real2, imag1, imag2, gain, size);		break;
+			case kScalar:																				break;
+		}
+
+		for (; i < size; i++)
+		{
+			double real = real1[i] - real2[i];
+			double imag = imag1[i] - imag2[i];
+
+			out[i] += ((real * real) + (imag * imag)) * gain;
+		}
+	}
+
+	// Clamped fifth root (out = in^(1/5) clamped to [lo, hi] - requires 0 < lo <= hi with lo^5 and hi^5 normal, NaNs give hi and out may be in)
+	// Roots are estimated from the bits of the input and refined by Newton's method, so no calls to pow() are needed
+
+	static void fifthRoot(double *out, const double *in, double lo, double hi, unsigned long size)
+	{
+		unsigned long i = 0;
+
+		switch (getType())
+		{
+			case kAVX2:		i = fifthRootAVX2(out, in, lo, hi, size);		break;
+			case kSSE2:		i = fifthRootSSE2(out, in, lo, hi, size);		break;
+			case kNEON:		i = fifthRootNEON(out, in, lo, hi, size);		break;
+			case kScalar:													break;
+		}
+
+		for (; i < size; i++)
+			out[i] = fifthRoot(in[i], lo, hi);
+	}
+
+	static double fifthRoot(double value, double lo, double hi)
+	{
+		double lo5 = power5(lo);
+		double hi5 = power5(hi);
+		double a = value < hi5 ? value : hi5;
+		a = a > lo5 ? a : lo5;
+
+		// Estimate (the upper 32 bits divided by five plus a bias - within 3.4%)
+
+		double high = (double) (doubleBits(a) >> 32);
+		double root = bitsDouble(doubleBits(((high * 0.2) + kRootBias) + kRootMagic) << 32);
+
+		// Refine
+
+		double aScaled = a * 0.2;
+
+		for (int j = 0; j < kRootIterations; j++)
+		{
+			double root2 = root * root;
+			root = (root * 0.8) + (aScaled / (root2 * root2));
+		}
+
+		root = root > lo ? root : lo;
+
+		return root < hi ? root : hi;
+	}
+
+	// Conversion to and from reduced precision storage
+	// Half precision values are IEEE binary16, saturated to the largest finite half (65504) and rounded to nearest even
+	// NaNs of any sign or payload are stored as the canonical quiet NaN (0x7E00) so that the data is the same on all CPUs
+	// Doubles are rounded to single precision first (as the hardware converts from float) - every path does this identically
+
+	static void convert(float *out, const double *in, unsigned long size)
+	{
+		unsigned long i = 0;
+
+		switch (getType())
+		{
+			case kAVX2:		i = convertAVX2(out, in, size);		break;
+			case kSSE2:		i = convertSSE2(out, in, size);		break;
+			case kNEON:		i = convertNEON(out, in, size);		break;
+			case kScalar:										break;
+		}
+
+		for (; i < size; i++)
+			out[i] = (float) in[i];
+	}
+
+	static void convert(double *out, const float *in, unsigned long size)
+	{
+		unsigned long i = 0;
+
+		switch (getType())
+		{
+			case kAVX2:		i = convertAVX2(out, in, size);		break;
+			case kSSE2:		i = convertSSE2(out, in, size);		break;
+			case kNEON:		i = convertNEON(out, in, size);		break;
+			case kScalar:										break;
+		}
+
+		for (; i < size; i++)
+			out[i] = in[i];
+	}
+
+	static void convert(uint16_t *out, const double *in, unsigned long size)
+	{
+		unsigned long i = 0;
+
+#if defined(HISSTOOLS_SIMD_X86)
+		if (hasF16C())
+			i = convertF16C(out, in, size);
+#elif defined(HISSTOOLS_SIMD_NEON)
+		i = convertNEON(out, in, size);
+#endif
+		for (; i < size; i++)
+			out[i] = doubleToHalf(in[i]);
+	}
+
+	static void convert(double *out, const uint16_t *in, unsigned long size)
+	{
+		unsigned long i = 0;
+
+#if defined(HISSTOOLS_SIMD_X86)
+		if (hasF16C())
+			i = convertF16C(out, in, size);
+#elif defined(HISSTOOLS_SIMD_NEON)
+		i = convertNEON(out, in, size);
+#endif
+		for (; i < size; i++)
+			out[i] = halfToDouble(in[i]);
+	}
+
+	// Scalar half precision conversion (bit manipulation, so no hardware support is required)
+
+	static uint16_t doubleToHalf(double value)
+	{
+		const uint32_t f16Max = (127 + 16) << 23;
+		const uint32_t f32Infinity = 255 << 23;
+		const uint32_t denormMagic = ((127 - 15) + (23 - 10) + 1) << 23;
+
+		if (value != value)
+			return 0x7E00;
+
+		float saturated = (float) (value > 65504.0 ? 65504.0 : (value < -65504.0 ? -65504.0 : value));
+		uint32_t bits = floatBits(saturated);
+		uint32_t sign = bits & 0x80000000U;
+		uint16_t half;
+
+		bits ^= sign;
+
+		if (bits >= f16Max)
+			half = bits > f32Infinity ? 0x7E00 : 0x7C00;
+		else if (bits < (113 << 23))
+		{
+			// Denormal (the addition performs the rounding)
+
+			half = (uint16_t) (floatBits(bitsFloat(bits) + bitsFloat(denormMagic)) - denormMagic);
+		}
+		else
+		{
+			// Normal (round to nearest even)
+
+			uint32_t mantissaOdd = (bits >> 13) & 1;
+
+			bits += ((uint32_t) (15 - 127) << 23) + 0xFFF + mantissaOdd;
+			half = (uint16_t) (bits >> 13);
+		}
+
+		return half | (uint16_t) (sign >> 16);
+	}
+
+	static double halfToDouble(uint16_t half)
+	{
+		const uint32_t shiftedExp = 0x7C00 << 13;
+
+		uint32_t bits = (half & 0x7FFF) << 13;
+		uint32_t exponent = bits & shiftedExp;
+
+		bits += (127 - 15) << 23;
+
+		if (exponent == shiftedExp)
+			bits += (128 - 16) << 23;
+		else if (!exponent)
+			bits = floatBits(bitsFloat(bits + (1 << 23)) - bitsFloat(113 << 23));
+
+		return bitsFloat(bits | ((half & 0x8000U) << 16));
+	}
+
+private:
+
+	// Fifth root constants (the magic number converts integers below 2^52 to and from the mantissa of a double)
+
+	static constexpr double kRootBias = 858116078.0;
+	static constexpr double kRootMagic = 4503599627370496.0;
+	static const int kRootIterations = 4;
+
+	static double power5(double x)
+	{
+		double x2 = x * x;
+		return x2 * x2 * x;
+	}
+
+	static uint64_t doubleBits(double value)
+	{
+		uint64_t bits;
+		memcpy(&bits, &value, sizeof(double));
+		return bits;
+	}
+
+	static double bitsDouble(uint64_t bits)
+	{
+		double value;
+		memcpy(&value, &bits, sizeof(double));
+		return value;
+	}
+
+	static uint32_t floatBits(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(float));
+		return bits;
+	}
+
+	static float bitsFloat(uint32_t bits)
+	{
+		float value;
+		memcpy(&value, &bits, sizeof(float));
+		return value;
+	}
+
+	static SIMDType detectType()
+	{
+#if defined(HISSTOOLS_SIMD_X86)
+		return hasAVX2() ? kAVX2 : kSSE2;
+#elif defined(HISSTOOLS_SIMD_NEON)
+		return kNEON;
+#else
+		return kScalar;
+#endif
+	}
+
+	static bool hasAVX2()
+	{
+#if defined(HISSTOOLS_SIMD_X86)
+#if defined(_MSC_VER) && !defined(__clang__)
+		int info[4];
+
+		// Check the CPU and OS both support AVX, then check for AVX2
+
+		__cpuid(info, 1);
+
+		if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)))
+			return false;
+		if ((_xgetbv(0) & 0x6) != 0x6)
+			return false;
+
+		__cpuidex(info, 7, 0);
+
+		return (info[1] & (1 << 5)) != 0;
+#else
+		__builtin_cpu_init();
+
+		return __builtin_cpu_supports("avx2");
+#endif
+#else
+		return false;
+#endif
+	}
+
+	static bool hasF16C()
+	{
+		static const bool f16c = detectF16C();
+
+		return f16c;
+	}
+
+	static bool detectF16C()
+	{
+#if defined(HISSTOOLS_SIMD_X86)
+#if defined(_MSC_VER) && !defined(__clang__)
+		int info[4];
+
+		// Check the CPU and OS both support AVX, then check for F16C
+
+		__cpuid(info, 1);
+
+		if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || !(info[2] & (1 << 29)))
+			return false;
+
+		return (_xgetbv(0) & 0x6) == 0x6;
+#else
+		__builtin_cpu_init();
+
+		return __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+#endif
+#else
+		return false;
+#endif
+	}
+
+	// Kernels return the number of samples processed (the caller deals with any remainder)
+
+#if defined(HISSTOOLS_SIMD_X86)
+
+	static unsigned long accumulateSSE2(double *out, const double *in, unsigned long size)
+	{
+		unsigned long i = 0;
+
+		for (; i + 4 <= size; i += 4)
+		{
+			__m128d a = _mm_add_pd(_mm_loadu_pd(out + i), _mm_loadu_pd(in + i));
+			__m128d b = _mm_add_pd(_mm_loadu_pd(out + i + 2), _mm_loadu_pd(in + i + 2));
+			_mm_storeu_pd(out + i, a);
+			_mm_storeu_pd(out + i + 2, b);
+		}
+
+		return i;
+	}
+
+	HISSTOOLS_TARGET_AVX2 static unsigned long accumulateAVX2(double *out, const double *in, unsigned long size)
+	{
+		unsigned long i = 0;
+
+		for (; i + 8 <= size; i += 8)
+		{
+			__m256d a = _mm256_add_pd(_mm256_loadu_pd(out + i), _mm256_loadu_pd(in + i));
+			__m256d b = _mm256_add_pd(_mm256_loadu_pd(out + i + 4), _mm256_loadu_pd(in + i + 4));
+			_mm256_storeu_pd(out + i, a);
+			_mm256_storeu_pd(out + i + 4, b);
+		}
+
+		return i;
+	}
+
+	static unsigned long accumulateSSE2(float *out, const float *in, unsigned long size)
+	{
+		unsigned long i = 0;
+
+		for (; i + 8 <= size; i += 8)
+		{
+			__m128 a = _mm_add_ps(_mm_loadu_ps(out + i), _mm_loadu_ps(in + i));
+			__m128 b = _mm_add_ps(_mm_loadu_ps(out + i + 4), _mm_loadu_ps(in + i + 4));
+			_mm_storeu_ps(out + i, a);
+			_mm_storeu_ps(out + i + 4, b);
+		}
+
+		return i;
+	}
+
+	HISSTOOLS_TARGET_AVX2 static unsigned long accumulateAVX2(float *out, const float *in, unsigned long size)
+	{
+		unsigned long i = 0;
+
+		for (; i + 16 <= size; i += 16)
+		{
+			__m256 a = _mm256_add_ps(_mm256_loadu_ps(out + i), _mm256_loadu_ps(in + i));
+			__m256 b = _mm256_add_ps(_mm256_loadu_ps(out + i + 8), _mm256_loadu_ps(in + i + 8));
+			_mm256_storeu_ps(out + i, a);
+			_mm256_storeu_ps(out + i + 8, b);
+		}
+
+		return i;
+	}
+
+	static unsigned long multiplySSE2(double *out, const double *in1, const double *in2, unsigned long size)
+	{
+		unsigned long i = 0;
+
+		for (; i + 4 <= size; i += 4)
+		{
+			__m128d a = _mm_mul_pd(_mm_loadu_pd(in1 + i), _mm_loadu_pd(in2 + i));
+			__m128d b = _mm_mul_pd(_mm_loadu_pd(in1 + i + 2), _mm_loadu_pd(in2 + i + 2));
+			_mm_storeu_pd(out + i, a);
+			_mm_storeu_pd(out + i + 2, b);
+		}
+
+		return i;
+	}
+
+	HISSTOOLS_TARGET_AVX2 static unsigned long multiplyAVX2(double *out, const double *in1, const double *in2, unsigned long size)
+	{
+		unsigned long i = 0;
+
+		for (; i + 8 <= size; i += 8)
+		{
+			__m256d a = _mm256_mul_pd(_mm256_loadu_pd(in1 + i), _mm256_loadu_pd(in2 + i));
+			__m256d b = _mm256_mul_pd(_mm256_loadu_pd(in1 + i + 4), _mm256_loadu_pd(in2 + i + 4));
+			_mm256_storeu_pd(out + i, a);
+			_mm256_storeu_pd(out + i + 4, b);
+		}
+
+		return i;
+	}
+
+	static unsigned long scaleSSE2(double *out, const double *in, double gain, unsigned long size)
+	{
+		__m128d g = _mm_set1_pd(gain);
+		unsigned long i = 0;
+
+		for (; i + 4 <= size; i += 4)
+		{
+			__m128d a = _mm_mul_pd(_mm_loadu_pd(in + i), g);
+			__m128d b = _mm_mul_pd(_mm_loadu_pd(in + i + 2), g);
+			_mm_storeu_pd(out + i, a);
+			_mm_storeu_pd(out + i + 2, b);
+		}
+
+		return i;
+	}
+
+	HISSTOOLS_TARGET_AVX2 static unsigned long scaleAVX2(double *out, const double *in, double gain, unsigned long size)
+	{
+		__m256d g = _mm256_set1_pd(gain);
+		unsigned long i = 0;
+
+		for (; i + 8 <= size; i += 8)
+		{
+			__m256d a = _mm256_mul_pd(_mm256_loadu_pd(in + i), g);
+			__m256d b = _mm256_mul_pd(_mm256_loadu_pd(in + i + 4), g);
+			_mm256_storeu_pd(out + i, a);
+			_mm256_storeu_pd(out + i + 4, b);
+		}
+
+		return i;
+	}
+
+	static unsigned long liftSSE2(double *out, const double *in1, const double *in2, double gain1, double gain2, unsigned long size)
+	{
+		__m128d g1 = _mm_set1_pd(gain1);
+		__m128d g2 = _mm_set1_pd(gain2);
+		unsigned long i = 0;
+
+		for (; i + 4 <= size; i += 4)
+		{
+			__m128d a = _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(in1 + i), g1), _mm_mul_pd(_mm_loadu_pd(in2 + i), g2));
+			__m128d b = _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(in1 + i + 2), g1), _mm_mul_pd(_mm_loadu_pd(in2 + i + 2), g2));
+			_mm_storeu_pd(out + i, _mm_add_pd(_mm_loadu_pd(out + i), a));
+			_mm_storeu_pd(out + i + 2, _mm_add_pd(_mm_loadu_pd(out + i + 2), b));
+		}
+
+		return i;
+	}
+
+	HISSTOOLS_TARGET_AVX2 static unsigned long liftAVX2(double *out, const double *in1, const double *in2, double gain1, double gain2, unsigned long size)
+	{
+		__m256d g1 = _mm256_set1_pd(gain1);
+		__m256d g2 = _mm256_set1_pd(gain2);
+		unsigned long i = 0;
+
+		for (; i + 8 <= size; i += 8)
+		{
+			__m256d a = _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(in1 + i), g1), _mm256_mul_pd(_mm256_loadu_pd(in2 + i), g2));
+			__m256d b = _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(in1 + i + 4), g1), _mm256_mul_pd(_mm256_loadu_pd(in2 + i + 4), g2));
+			_mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(out + i), a));
+			_mm256_storeu_pd(out + i + 4, _mm256_add_pd(_mm256_loadu_pd(out + i + 4), b));
+		}
+
+		return i;
+	}
+
+	static unsigned long differencePowerSSE2(double *out, const double *real1, const double *real2, const double *imag1, const double *imag2, double gain, unsigned long size)
+	{
+		__m128d g = _mm_set1_pd(gain);
+		unsigned long i = 0;
+
+		for (; i + 4 <= size; i += 4)
+		{
+			__m128d r1 = _mm_sub_pd(_mm_loadu_pd(real1 + i), _mm_loadu_pd(real2 + i));
+			__m128d i1 = _mm_sub_pd(_mm_loadu_pd(imag1 + i), _mm_loadu_pd(imag2 + i));
+			__m128d r2 = _mm_sub_pd(_mm_loadu_pd(real1 + i + 2), _mm_loadu_pd(real2 + i + 2));
+			__m128d i2 = _mm_sub_pd(_mm_loadu_pd(imag1 + i + 2), _mm_loadu_pd(imag2 + i + 2));
+			__m128d a = _mm_mul_pd(_mm_add_pd(_mm_mul_pd(r1, r1), _mm_mul_pd(i1, i1)), g);
+			__m128d b = _mm_mul_pd(_mm_add_pd(_mm_mul_pd(r2, r2), _mm_mul_pd(i2, i2)), g);
+			_mm_storeu_pd(out + i, _mm_add_pd(_mm_loadu_pd(out + i), a));
+			_mm_storeu_pd(out + i + 2, _mm_add_pd(_mm_loadu_pd(out + i + 2), b));
+		}
+
+		return i;
+	}
+
+	HISSTOOLS_TARGET_AVX2 static unsigned long differencePowerAVX2(double *out, const double *real1, const double *real2, const double *imag1, const double *imag2, double gain, unsigned long size)
+	{
+		__m256d g = _mm256_set1_pd(gain);
+		unsigned long i = 0;
+
+		for (; i + 8 <= size; i += 8)
+		{
+			__m256d r1 = _mm256_sub_pd(_mm256_loadu_pd(real1 + i), _mm256_loadu_pd(real2 + i));
+			__m256d i1 = _mm256_sub_pd(_mm256_loadu_pd(imag1 + i), _mm256_loadu_pd(imag2 + i));
+			__m256d r2 = _mm256_sub_pd(_mm256_loadu_pd(real1 + i + 4), _mm256_loadu_pd(real2 + i + 4));
+			__m256d i2 = _mm256_sub_pd(_mm256_loadu_pd(imag1 + i + 4), _mm256_loadu_pd(imag2 + i + 4));
+			__m256d a = _mm256_mul_pd(_mm256_add_pd(_mm256_mul_pd(r1, r1), _mm256_mul_pd(i1, i1)), g);
+			__m256d b = _mm256_mul_pd(_mm256_add_pd(_mm256_mul_pd(r2, r2), _mm256_mul_pd(i2, i2)), g);
+			_mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(out + i), a));
+			_mm256_storeu_pd(out + i + 4, _mm256_add_pd(_mm256_loadu_pd(out + i + 4), b));
+		}
+
+		return i;
+	}
+
+	static unsigned long fifthRootSSE2(double *out, const double *in, double lo, double hi, unsigned long size)
+	{
+		__m128d vLo = _mm_set1_pd(lo);
+		__m128d vHi = _mm_set1_pd(hi);
+		__m128d lo5 = _mm_set1_pd(power5(lo));
+		__m128d hi5 = _mm_set1_pd(power5(hi));
+		__m128d bias = _mm_set1_pd(kRootBias);
+		__m128d magic = _mm_set1_pd(kRootMagic);
+		__m128d fifth = _mm_set1_pd(0.2);
+		__m128d fourFifths = _mm_set1_pd(0.8);
+		unsigned long i = 0;
+
+		for (; i + 2 <= size; i += 2)
+		{
+			__m128d a = _mm_max_pd(_mm_min_pd(_mm_loadu_pd(in + i), hi5), lo5);
+			__m128i high = _mm_srli_epi64(_mm_castpd_si128(a), 32);
+			__m128d h = _mm_sub_pd(_mm_castsi128_pd(_mm_or_si128(high, _mm_castpd_si128(magic))), magic);
+			__m128d estimate = _mm_add_pd(_mm_add_pd(_mm_mul_pd(h, fifth), bias), magic);
+			__m128d root = _mm_castsi128_pd(_mm_slli_epi64(_mm_castpd_si128(estimate), 32));
+			__m128d aScaled = _mm_mul_pd(a, fifth);
+
+			for (int j = 0; j < kRootIterations; j++)
+			{
+				__m128d root2 = _mm_mul_pd(root, root);
+				root = _mm_add_pd(_mm_mul_pd(root, fourFifths), _mm_div_pd(aScaled, _mm_mul_pd(root2, root2)));
+			}
+
+			_mm_storeu_pd(out + i, _mm_min_pd(_mm_max_pd(root, vLo), vHi));
+		}
+
+		return i;
+	}
+
+	HISSTOOLS_TARGET_AVX2 static unsigned long fifthRootAVX2(double *out, const double *in, double lo, double hi, unsigned long size)
+	{
+		__m256d vLo = _mm256_set1_pd(lo);
+		__m256d vHi = _mm256_set1_pd(hi);
+		__m256d lo5 = _mm256_set1_pd(power5(lo));
+		__m256d hi5 = _mm256_set1_pd(power5(hi));
+		__m256d bias = _mm256_set1_pd(kRootBias);
+		__m256d magic = _mm256_set1_pd(kRootMagic);
+		__m256d fifth = _mm256_set1_pd(0.2);
+		__m256d fourFifths = _mm256_set1_pd(0.8);
+		unsigned long i = 0;
+
+		for (; i + 4 <= size; i += 4)
+		{
+			__m256d a = _mm256_max_pd(_mm256_min_pd(_mm256_loadu_pd(in + i), hi5), lo5);
+			__m256i high = _mm256_srli_epi64(_mm256_castpd_si256(a), 32);
+			__m256d h = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(high, _mm256_castpd_si256(magic))), magic);
+			__m256d estimate = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(h, fifth), bias), magic);
+			__m256d root = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_castpd_si256(estimate), 32));
+			__m256d aScaled = _mm256_mul_pd(a, fifth);
+
+			for (int j = 0; j < kRootIterations; j++)
+			{
+				__m256d root2 = _mm256_mul_pd(root, root);
+				root = _mm256_add_pd(_mm256_mul_pd(root, fourFifths), _mm256_div_pd(aScaled, _mm256_mul_pd(root2, root2)));
+			}
+
+			_mm256_storeu_pd(out + i, _mm256_min_pd(_mm256_max_pd(root, vLo), vHi));
+		}
+
+		return i;
+	}
+
+	static unsigned long multiplySSE2(float *out, const float *in1, const float *in2, unsigned long size)
+	{
+		unsigned long i = 0;
+
+		for (; i + 8 <= size; i += 8)
+		{
+			__m128 a = _mm_mul_ps(_mm_loadu_ps(in1 + i), _mm_loadu_ps(in2 + i));
+			__m128 b = _mm_mul_ps(_mm_loadu_ps(in1 + i + 4), _mm_loadu_ps(in2 + i + 4));
+			_mm_storeu_ps(out + i, a);
+			_mm_storeu_ps(out + i + 4, b);
+		}
+
+		return i;
+	}
+
+	HISSTOOLS_TARGET_AVX2 static unsigned long multiplyAVX2(float *out, const float *in1, const float *in2, unsigned long size)
+	{
+		unsigned long i = 0;
+
+		for (; i + 16 <= size; i += 16)
+		{
+			__m256 a = _mm256_mul_ps(_mm256_loadu_ps(in1 + i), _mm256_loadu_ps(in2 + i));
+			__m256 b = _mm256_mul_ps(_mm256_loadu_ps(in1 + i + 8), _mm256_loadu_ps(in2 + i + 8));
+			_mm256_storeu_ps(out + i, a);
+			_mm256_storeu_ps(out + i + 8, b);
+		}
+
+		return i;
+	}
+
+	static unsigned long convertSSE2(float *out, const double *in, unsigned long size)
+	{
+		unsigned long i = 0;
+
+		for (; i + 4 <= size; i += 4)
+		{
+			__m128 a = _mm_cvtpd_ps(_mm_loadu_pd(in + i));
+			__m128 b = _mm_cvtpd_ps(_mm_loadu_pd(in + i + 2));
+			_mm_storeu_ps(out + i, _mm_movelh_ps(a, b));
+		}
+
+		return i;
+	}
+
+	static unsigned long convertSSE2(double *out, const float *in, unsigned long size)
+	{
+		unsigned long i = 0;
+
+		for (; i + 4 <= size; i += 4)
+		{
+			__m128 a = _mm_loadu_ps(in + i);
+			_mm_storeu_pd(out + i, _mm_cvtps_pd(a));
+			_mm_storeu_pd(out + i + 2, _mm_cvtps_pd(_mm_movehl_ps(a, a)));
+		}
+
+		return i;
+	}
+
+	HISSTOOLS_TARGET_AVX2 static unsigned long convertAVX2(float *out, const double *in, unsigned long size)
+	{
+		unsigned long i = 0;
+
+		for (; i + 8 <= size; i += 8)
+		{
+			_mm_storeu_ps(out + i, _mm256_cvtpd_ps(_mm256_loadu_pd(in + i)));
+			_mm_storeu_ps(out + i + 4, _mm256_cvtpd_ps(_mm256_loadu_pd(in + i + 4)));
+		}
+
+		return i;
+	}
+
+	HISSTOOLS_TARGET_AVX2 static unsigned long convertAVX2(double *out, const float *in, unsigned long size)
+	{
+		unsigned long i = 0;
+
+		for (; i + 8 <= size; i += 8)
+		{
+			_mm256_storeu_pd(out + i, _mm256_cvtps_pd(_mm_loadu_ps(in + i)));
+			_mm256_storeu_pd(out + i + 4, _mm256_cvtps_pd(_mm_loadu_ps(in + i + 4)));
+		}
+
+		return i;
+	}
+
+	// N.B. min / max return the second operand for NaNs, so NaNs are replaced explicitly with the canonical quiet NaN
+
+	HISSTOOLS_TARGET_F16C static __m256d saturateF16C(__m256d x, __m256d maxValue, __m256d minValue, __m256d nanValue)
+	{
+		__m256d saturated = _mm256_max_pd(_mm256_min_pd(x, maxValue), minValue);
+		return _mm256_blendv_pd(saturated, nanValue, _mm256_cmp_pd(x, x, _CMP_UNORD_Q));
+	}
+
+	HISSTOOLS_TARGET_F16C static unsigned long convertF16C(uint16_t *out, const double *in, unsigned long size)
+	{
+		const __m256d maxValue = _mm256_set1_pd(65504.0);
+		const __m256d minValue = _mm256_set1_pd(-65504.0);
+		const __m256d nanValue = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7FF8000000000000LL));
+
+		unsigned long i = 0;
+
+		for (; i + 8 <= size; i += 8)
+		{
+			__m128 a = _mm256_cvtpd_ps(saturateF16C(_mm256_loadu_pd(in + i), maxValue, minValue, nanValue));
+			__m128 b = _mm256_cvtpd_ps(saturateF16C(_mm256_loadu_pd(in + i + 4), maxValue, minValue, nanValue));
+			__m256 c = _mm256_insertf128_ps(_mm256_castps128_ps256(a), b, 1);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm256_cvtps_ph(c, _MM_FROUND_TO_NEAREST_INT));
+		}
+
+		return i;
+	}
+
+	HISSTOOLS_TARGET_F16C static unsigned long convertF16C(double *out, const uint16_t *in, unsigned long size)
+	{
+		unsigned long i = 0;
+
+		for (; i + 8 <= size; i += 8)
+		{
+			__m256 a = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i)));
+			_mm256_storeu_pd(out + i, _mm256_cvtps_pd(_mm256_castps256_ps128(a)));
+			_mm256_storeu_pd(out + i + 4, _mm256_cvtps_pd(_mm256_extractf128_ps(a, 1)));
+		}
+
+		return i;
+	}
+
+#else
+
+	template <class T> static unsigned long accumulateSSE2(T *, const T *, unsigned long)	{ return 0; }
+	template <class T> static unsigned long accumulateAVX2(T *, const T *, unsigned long)	{ return 0; }
+	template <class T> static unsigned long multiplySSE2(T *, const T *, const T *, unsigned long)	{ return 0; }
+	template <class T> static unsigned long multiplyAVX2(T *, const T *, const T *, unsigned long)	{ return 0; }
+	template <class T> static unsigned long scaleSSE2(T *, const T *, T, unsigned long)	{ return 0; }
+	template <class T> static unsigned long scaleAVX2(T *, const T *, T, unsigned long)	{ return 0; }
+	template <class T> static unsigned long liftSSE2(T *, const T *, const T *, T, T, unsigned long)	{ return 0; }
+	template <class T> static unsigned long liftAVX2(T *, const T *, const T *, T, T, unsigned long)	{ return 0; }
+	template <class T> static unsigned long differencePowerSSE2(T *, const T *, const T *, const T *, const T *, T, unsigned long)	{ return 0; }
+	template <class T> static unsigned long differencePowerAVX2(T *, const T *, const T *, const T *, const T *, T, unsigned long)	{ return 0; }
+	template <class T> static unsigned long fifthRootSSE2(T *, const T *, T, T, unsigned long)	{ return 0; }
+	template <class T> static unsigned long fifthRootAVX2(T *, const T *, T, T, unsigned long)	{ return 0; }
+	template <class T, class U> static unsigned long convertSSE2(T *, const U *, unsigned long)	{ return 0; }
+	template <class T, class U> static unsigned long convertAVX2(T *, const U *, unsigned long)	{ return 0; }
+
+#endif
+
+#if defined(HISSTOOLS_SIMD_NEON)
+
+	static unsigned long accumulateNEON(double *out, const double *in, unsigned long size)
+	{
+		unsigned long i = 0;
+
+		for (; i + 4 <= size; i += 4)
+		{
+			float64x2_t a = vaddq_f64(vld1q_f64(out + i), vld1q_f64(in + i));
+			float64x2_t b = vaddq_f64(vld1q_f64(out + i + 2), vld1q_f64(in + i + 2));
+			vst1q_f64(out + i, a);
+			vst1q_f64(out + i + 2, b);
+		}
+
+		return i;
+	}
+
+	static unsigned long accumulateNEON(float *out, const float *in, unsigned long size)
+	{
+		unsigned long i = 0;
+
+		for (; i + 8 <= size; i += 8)
+		{
+			float32x4_t a = vaddq_f32(vld1q_f32(out + i), vld1q_f32(in + i));
+			float32x4_t b = vaddq_f32(vld1q_f32(out + i + 4), vld1q_f32(in + i + 4));
+			vst1q_f32(out + i, a);
+			vst1q_f32(out + i + 4, b);
+		}
+
+		return i;
+	}
+
+	static unsigned long multiplyNEON(double *out, const double *in1, const double *in2, unsigned long size)
+	{
+		unsigned long i = 0;
+
+		for (; i + 4 <= size; i += 4)
+		{
+			float64x2_t a = vmulq_f64(vld1q_f64(in1 + i), vld1q_f64(in2 + i));
+			float64x2_t b = vmulq_f64(vld1q_f64(in1 + i + 2), vld1q_f64(in2 + i + 2));
+			vst1q_f64(out + i, a);
+			vst1q_f64(out + i + 2, b);
+		}
+
+		return i;
+	}
+
+	static unsigned long scaleNEON(double *out, const double *in, double gain, unsigned long size)
+	{
+		unsigned long i = 0;
+
+		for (; i + 4 <= size; i += 4)
+		{
+			float64x2_t a = vmulq_n_f64(vld1q_f64(in + i), gain);
+			float64x2_t b = vmulq_n_f64(vld1q_f64(in + i + 2), gain);
+			vst1q_f64(out + i, a);
+			vst1q_f64(out + i + 2, b);
+		}
+
+		return i;
+	}
+
+	static unsigned long liftNEON(double *out, const double *in1, const double *in2, double gain1, double gain2, unsigned long size)
+	{
+		unsigned long i = 0;
+
+		for (; i + 4 <= size; i += 4)
+		{
+			float64x2_t a = vfmaq_n_f64(vmulq_n_f64(vld1q_f64(in1 + i), gain1), vld1q_f64(in2 + i), gain2);
+			float64x2_t b = vfmaq_n_f64(vmulq_n_f64(vld1q_f64(in1 + i + 2), gain1), vld1q_f64(in2 + i + 2), gain2);
+			vst1q_f64(out + i, vaddq_f64(vld1q_f64(out + i), a));
+			vst1q_f64(out + i + 2, vaddq_f64(vld1q_f64(out + i + 2), b));
+		}
+
+		return i;
+	}
+
+	static unsigned long differencePowerNEON(double *out, const double *real1, const double *real2, const double *imag1, const double *imag2, double gain, unsigned long size)
+	{
+		unsigned long i = 0;
+
+		for (; i + 4 <= size; i += 4)
+		{
+			float64x2_t r1 = vsubq_f64(vld1q_f64(real1 + i), vld1q_f64(real2 + i));
+			float64x2_t i1 = vsubq_f64(vld1q_f64(imag1 + i), vld1q_f64(imag2 + i));
+			float64x2_t r2 = vsubq_f64(vld1q_f64(real1 + i + 2), vld1q_f64(real2 + i + 2));
+			float64x2_t i2 = vsubq_f64(vld1q_f64(imag1 + i + 2), vld1q_f64(imag2 + i + 2));
+			float64x2_t a = vmulq_n_f64(vaddq_f64(vmulq_f64(r1, r1), vmulq_f64(i1, i1)), gain);
+			float64x2_t b = vmulq_n_f64(vaddq_f64(vmulq_f64(r2, r2), vmulq_f64(i2, i2)), gain);
+			vst1q_f64(out + i, vaddq_f64(vld1q_f64(out + i), a));
+			vst1q_f64(out + i + 2, vaddq_f64(vld1q_f64(out + i + 2), b));
+		}
+
+		return i;
+	}
+
+	static unsigned long fifthRootNEON(double *out, const double *in, double lo, double hi, unsigned long size)
+	{
+		float64x2_t vLo = vdupq_n_f64(lo);
+		float64x2_t vHi = vdupq_n_f64(hi);
+		float64x2_t lo5 = vdupq_n_f64(power5(lo));
+		float64x2_t hi5 = vdupq_n_f64(power5(hi));
+		float64x2_t bias = vdupq_n_f64(kRootBias);
+		float64x2_t magic = vdupq_n_f64(kRootMagic);
+		unsigned long i = 0;
+
+		for (; i + 2 <= size; i += 2)
+		{
+			// Comparisons and selects (rather than min / max) so that NaNs give hi
+
+			float64x2_t a = vld1q_f64(in + i);
+			a = vbslq_f64(vcltq_f64(a, hi5), a, hi5);
+			a = vbslq_f64(vcgtq_f64(a, lo5), a, lo5);
+
+			uint64x2_t high = vshrq_n_u64(vreinterpretq_u64_f64(a), 32);
+			float64x2_t h = vsubq_f64(vreinterpretq_f64_u64(vorrq_u64(high, vreinterpretq_u64_f64(magic))), magic);
+			float64x2_t estimate = vaddq_f64(vaddq_f64(vmulq_n_f64(h, 0.2), bias), magic);
+			float64x2_t root = vreinterpretq_f64_u64(vshlq_n_u64(vreinterpretq_u64_f64(estimate), 32));
+			float64x2_t aScaled = vmulq_n_f64(a, 0.2);
+
+			for (int j = 0; j < kRootIterations; j++)
+			{
+				float64x2_t root2 = vmulq_f64(root, root);
+				root = vaddq_f64(vmulq_n_f64(root, 0.8), vdivq_f64(aScaled, vmulq_f64(root2, root2)));
+			}
+
+			root = vbslq_f64(vcgtq_f64(root, vLo), root, vLo);
+			vst1q_f64(out + i, vbslq_f64(vcltq_f64(root, vHi), root, vHi));
+		}
+
+		return i;
+	}
+
+	static unsigned long multiplyNEON(float *out, const float *in1, const float *in2, unsigned long size)
+	{
+		unsigned long i = 0;
+
+		for (; i + 8 <= size; i += 8)
+		{
+			float32x4_t a = vmulq_f32(vld1q_f32(in1 + i), vld1q_f32(in2 + i));
+			float32x4_t b = vmulq_f32(vld1q_f32(in1 + i + 4), vld1q_f32(in2 + i + 4));
+			vst1q_f32(out + i, a);
+			vst1q_f32(out + i + 4, b);
+		}
+
+		return i;
+	}
+
+	static unsigned long convertNEON(float *out, const double *in, unsigned long size)
+	{
+		unsigned long i = 0;
+
+		for (; i + 4 <= size; i += 4)
+			vst1q_f32(out + i, vcvt_high_f32_f64(vcvt_f32_f64(vld1q_f64(in + i)), vld1q_f64(in + i + 2)));
+
+		return i;
+	}
+
+	static unsigned long convertNEON(double *out, const float *in, unsigned long size)
+	{
+		unsigned long i = 0;
+
+		for (; i + 4 <= size; i += 4)
+		{
+			float32x4_t a = vld1q_f32(in + i);
+			vst1q_f64(out + i, vcvt_f64_f32(vget_low_f32(a)));
+			vst1q_f64(out + i + 2, vcvt_high_f64_f32(a));
+		}
+
+		return i;
+	}
+
+	// N.B. vmin / vmax propagate NaNs (with their payload), so NaNs are replaced explicitly with the canonical quiet NaN
+
+	static float64x2_t saturateNEON(float64x2_t x, float64x2_t maxValue, float64x2_t minValue, float64x2_t nanValue)
+	{
+		float64x2_t saturated = vmaxq_f64(vminq_f64(x, maxValue), minValue);
+		return vbslq_f64(vceqq_f64(x, x), saturated, nanValue);
+	}
+
+	static unsigned long convertNEON(uint16_t *out, const double *in, unsigned long size)
+	{
+		const float64x2_t maxValue = vdupq_n_f64(65504.0);
+		const float64x2_t minValue = vdupq_n_f64(-65504.0);
+		const float64x2_t nanValue = vreinterpretq_f64_u64(vdupq_n_u64(0x7FF8000000000000ULL));
+
+		unsigned long i = 0;
+
+		for (; i + 4 <= size; i += 4)
+		{
+			float64x2_t a = saturateNEON(vld1q_f64(in + i), maxValue, minValue, nanValue);
+			float64x2_t b = saturateNEON(vld1q_f64(in + i + 2), maxValue, minValue, nanValue);
+			float32x4_t c = vcvt_high_f32_f64(vcvt_f32_f64(a), b);
+			vst1_u16(out + i, vreinterpret_u16_f16(vcvt_f16_f32(c)));
+		}
+
+		return i;
+	}
+
+	static unsigned long convertNEON(double *out, const uint16_t *in, unsigned long size)
+	{
+		unsigned long i = 0;
+
+		for (; i + 4 <= size; i += 4)
+		{
+			float32x4_t a = vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(in + i)));
+			vst1q_f64(out + i, vcvt_f64_f32(vget_low_f32(a)));
+			vst1q_f64(out + i + 2, vcvt_high_f64_f32(a));
+		}
+
+		return i;
+	}
+
+#else
+
+	template <class T> static unsigned long accumulateNEON(T *, const T *, unsigned long)	{ return 0; }
+	template <class T> static unsigned long multiplyNEON(T *, const T *, const T *, unsigned long)	{ return 0; }
+	template <class T> static unsigned long scaleNEON(T *, const T *, T, unsigned long)	{ return 0; }
+	template <class T> static unsigned long liftNEON(T *, const T *, const T *, T, T, unsigned long)	{ return 0; }
+	template <class T> static unsigned long differencePowerNEON(T *, const T *, const T *, const T *, const T *, T, unsigned long)	{ return 0; }
+	template <class T> static unsigned long fifthRootNEON(T *, const T *, T, T, unsigned long)	{ return 0; }
+	template <class T, class U> static unsigned long convertNEON(T *, const U *, unsigned long)	{ return 0; }
+
+#endif
+};
+
+
+#endif
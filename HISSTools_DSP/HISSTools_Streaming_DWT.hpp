@@ -0,0 +1,293 @@
+
+
+#ifndef __HISSTOOLS_STREAMING_DWT__
+#define __HISSTOOLS_STREAMING_DWT__
+
+#include <algorithm>
+#include "HISSTools_DWT.hpp"
+
+
+// Streaming multi-level DWT / IDWT for continuous signals (a decimated filter bank using the FIR filters of a wavelet)
+
+// Filter state is kept for each level between calls, so blocks may be any size (larger blocks are split internally)
+// The coefficients produced by each block are passed to processDetails() and processApproximation() to be modified
+// The output is the resynthesised signal delayed by getLatency() samples (perfectly reconstructed if nothing is modified)
+
+// The wavelet is not copied, and should not be changed or deleted whilst in use
+// Filter offsets are ignored (they align the circular transform, and have no meaning for a causal stream)
+
+class HISSTools_Streaming_DWT
+{
+
+public:
+
+	HISSTools_Streaming_DWT(HISSTools_Wavelet *wavelet, unsigned long levels, unsigned long maxBlockSize = 4096)
+	: mWavelet(wavelet), mNLevels(levels < 1 ? 1 : levels), mMaxBlockSize(maxBlockSize < 2 ? 2 : maxBlockSize)
+	{
+		unsigned long forwardLength = mWavelet->mForwardLength;
+		unsigned long inverseLength = mWavelet->mInverseLength;
+
+		// The delay of a single level (see getLatency())
+
+		unsigned long singleDelay = forwardLength ? forwardLength - 1 : 0;
+
+		mLevels = new Level[mNLevels];
+		mLatency = 0;
+
+		// Details are delayed to match the reconstruction of the approximation at the same level
+
+		for (unsigned long i = mNLevels; i--; )
+		{
+			Level &level = mLevels[i];
+
+			level.mHistory = new double[forwardLength * 2];
+			level.mAccumulator = new double[inverseLength];
+			level.mCoefficients = new double[(mMaxBlockSize >> (i + 1)) + 2];
+			level.mDelaySize = mLatency;
+			level.mDelay = new double[mLatency + 1];
+
+			mLatency = (mLatency * 2) + singleDelay;
+		}
+
+		mApproximation = new double[(mMaxBlockSize >> mNLevels) + 2];
+
+		reset();
+	}
+
+
+	virtual ~HISSTools_Streaming_DWT()
+	{
+		for (unsigned long i = 0; i < mNLevels; i++)
+		{
+			delete[] mLevels[i].mHistory;
+			delete[] mLevels[i].mAccumulator;
+			delete[] mLevels[i].mCoefficients;
+			delete[] mLevels[i].mDelay;
+		}
+
+		delete[] mLevels;
+		delete[] mApproximation;
+	}
+
+
+	// Non-copyable
+
+	HISSTools_Streaming_DWT(const HISSTools_Streaming_DWT&) = delete;
+	HISSTools_Streaming_DWT& operator=(const HISSTools_Streaming_DWT&) = delete;
+
+
+	void reset()
+	{
+		for (unsigned long i = 0; i < mNLevels; i++)
+		{
+			Level &level = mLevels[i];
+
+			for (unsigned long j = 0; j < mWavelet->mForwardLength * 2; j++)
+				level.mHistory[j] = 0.0;
+			for (unsigned long j = 0; j < mWavelet->mInverseLength; j++)
+				level.mAccumulator[j] = 0.0;
+			for (unsigned long j = 0; j < level.mDelaySize; j++)
+				level.mDelay[j] = 0.0;
+
+			level.mHistoryPosition = 0;
+			level.mAccumulatorPosition = 0;
+			level.mDelayPosition = 0;
+			level.mAnalysisCount = 0;
+			level.mSynthesisCount = 0;
+		}
+	}
+
+
+	// Latency in samples (each level adds the forward filter length - 1, and doubles the latency of the levels below it)
+
+	unsigned long getLatency() const
+	{
+		return mLatency;
+	}
+
+
+	unsigned long getNLevels() const
+	{
+		return mNLevels;
+	}
+
+
+	// The input and output may be the same
+
+	void process(const double *in, double *out, unsigned long nSamps)
+	{
+		for (unsigned long i = 0; i < nSamps; i += mMaxBlockSize)
+		{
+			unsigned long blockSize = std::min(nSamps - i, mMaxBlockSize);
+
+			// Analyse the whole block
+
+			for (unsigned long j = 0; j < mNLevels; j++)
+				mLevels[j].mNCoefficients = mLevels[j].mReadPosition = 0;
+			mNApproximation = mApproximationReadPosition = 0;
+
+			for (unsigned long j = 0; j < blockSize; j++)
+				analyse(0, in[i + j]);
+
+			// Process coefficients
+
+			for (unsigned long j = 0; j < mNLevels; j++)
+				if (mLevels[j].mNCoefficients)
+					processDetails(mLevels[j].mCoefficients, mLevels[j].mNCoefficients, j);
+
+			if (mNApproximation)
+				processApproximation(mApproximation, mNApproximation);
+
+			// Resynthesise
+
+			for (unsigned long j = 0; j < blockSize; j++)
+				out[i + j] = synthesise(0);
+		}
+	}
+
+
+	void process(double *io, unsigned long nSamps)
+	{
+		process(io, io, nSamps);
+	}
+
+
+protected:
+
+	virtual void processDetails(double *coefficients, unsigned long size, unsigned long level)
+	{
+		// This function should be overridden to modify the detail coefficients of a given level (level 0 is the finest)
+	}
+
+	virtual void processApproximation(double *coefficients, unsigned long size)
+	{
+		// This function should be overridden to modify the approximation coefficients of the coarsest level
+	}
+
+
+private:
+
+	// Analysis (one input sample to a level, producing a pair of coefficients on every other sample)
+
+	void analyse(unsigned long levelIdx, double x)
+	{
+		Level &level = mLevels[levelIdx];
+
+		const double *loPass = mWavelet->mForwardLoPass;
+		const double *hiPass = mWavelet->mForwardHiPass;
+		unsigned long length = mWavelet->mForwardLength;
+
+		// The history is stored twice so that the most recent samples are always contiguous
+
+		level.mHistory[level.mHistoryPosition] = x;
+		level.mHistory[level.mHistoryPosition + length] = x;
+		level.mHistoryPosition = level.mHistoryPosition + 1 == length ? 0 : level.mHistoryPosition + 1;
+
+		if (level.mAnalysisCount++ & 1)
+		{
+			const double *history = level.mHistory + level.mHistoryPosition;
+			double lo = 0.0;
+			double hi = 0.0;
+
+			for (unsigned long i = 0; i < length; i++)
+			{
+				lo += loPass[i] * history[i];
+				hi += hiPass[i] * history[i];
+			}
+
+			level.mCoefficients[level.mNCoefficients++] = hi;
+
+			if (levelIdx + 1 < mNLevels)
+				analyse(levelIdx + 1, lo);
+			else
+				mApproximation[mNApproximation++] = lo;
+		}
+	}
+
+	// Synthesis (one output sample from a level, consuming a pair of coefficients on the same samples as the analysis)
+
+	double synthesise(unsigned long levelIdx)
+	{
+		Level &level = mLevels[levelIdx];
+
+		const double *loPass = mWavelet->mInverseLoPass;
+		const double *hiPass = mWavelet->mInverseHiPass;
+		unsigned long length = mWavelet->mInverseLength;
+
+		if (level.mSynthesisCount++ & 1)
+		{
+			double lo = levelIdx + 1 < mNLevels ? synthesise(levelIdx + 1) : mApproximation[mApproximationReadPosition++];
+			double hi = level.mCoefficients[level.mReadPosition++];
+
+			// Delay the details to match the approximation
+
+			if (level.mDelaySize)
+			{
+				double delayed = level.mDelay[level.mDelayPosition];
+				level.mDelay[level.mDelayPosition] = hi;
+				level.mDelayPosition = level.mDelayPosition + 1 == level.mDelaySize ? 0 : level.mDelayPosition + 1;
+				hi = delayed;
+			}
+
+			// Overlap-add the filters from the current output position
+
+			for (unsigned long i = 0, j = level.mAccumulatorPosition; i < length; i++, j = j + 1 == length ? 0 : j + 1)
+				level.mAccumulator[j] += (loPass[i] * lo) + (hiPass[i] * hi);
+		}
+
+		double y = level.mAccumulator[level.mAccumulatorPosition];
+		level.mAccumulator[level.mAccumulatorPosition] = 0.0;
+		level.mAccumulatorPosition = level.mAccumulatorPosition + 1 == length ? 0 : level.mAccumulatorPosition + 1;
+
+		return y;
+	}
+
+
+	struct Level
+	{
+		// Analysis
+
+		double *mHistory;
+		unsigned long mHistoryPosition;
+		unsigned long mAnalysisCount;
+
+		// Coefficients for the current block
+
+		double *mCoefficients;
+		unsigned long mNCoefficients;
+		unsigned long mReadPosition;
+
+		// Synthesis
+
+		double *mDelay;
+		unsigned long mDelaySize;
+		unsigned long mDelayPosition;
+
+		double *mAccumulator;
+		unsigned long mAccumulatorPosition;
+		unsigned long mSynthesisCount;
+	};
+
+	// Wavelet
+
+	HISSTools_Wavelet *mWavelet;
+
+	// Levels
+
+	unsigned long mNLevels;
+	Level *mLevels;
+
+	// Approximation for the current block
+
+	double *mApproximation;
+	unsigned long mNApproximation;
+	unsigned long mApproximationReadPosition;
+
+	// Parameters
+
+	unsigned long mMaxBlockSize;
+	unsigned long mLatency;
+};
+
+
+#endif
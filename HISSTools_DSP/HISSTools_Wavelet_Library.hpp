@@ -0,0 +1,693 @@
+
+
+#ifndef __HISSTOOLS_WAVELET_LIBRARY__
+#define __HISSTOOLS_WAVELET_LIBRARY__
+
+#include "HISSTools_DWT.hpp"
+
+
+// Standard wavelets with precomputed coefficients (accurate to double precision)
+
+// Daubechies wavelets have extremal phase, and symlets are the least asymmetric choice of the same spectral factorisation
+// Coiflets are the exact solutions of their moment conditions (published tables for coif4 and coif5 are only accurate to 1e-8 and 1e-5)
+// The biorthogonal wavelets are the Cohen-Daubechies-Feauveau spline family (biorNr.Nd) and CDF 9/7 (bior4.4)
+// Biorthogonal filters are zero padded so that both lowpass filters have the same even length
+
+// All lowpass filters have a DC gain of sqrt(2) and are stored in the order HISSTools_Wavelet expects (reversed for correlation)
+
+class HISSTools_Wavelet_Library
+{
+
+public:
+
+	enum Type
+	{
+		kHaar,
+		kDaubechies2,
+		kDaubechies3,
+		kDaubechies4,
+		kDaubechies5,
+		kDaubechies6,
+		kDaubechies7,
+		kDaubechies8,
+		kDaubechies9,
+		kDaubechies10,
+		kDaubechies11,
+		kDaubechies12,
+		kDaubechies13,
+		kDaubechies14,
+		kDaubechies15,
+		kDaubechies16,
+		kDaubechies17,
+		kDaubechies18,
+		kDaubechies19,
+		kDaubechies20,
+		kSymlet2,
+		kSymlet3,
+		kSymlet4,
+		kSymlet5,
+		kSymlet6,
+		kSymlet7,
+		kSymlet8,
+		kSymlet9,
+		kSymlet10,
+		kSymlet11,
+		kSymlet12,
+		kSymlet13,
+		kSymlet14,
+		kSymlet15,
+		kSymlet16,
+		kSymlet17,
+		kSymlet18,
+		kSymlet19,
+		kSymlet20,
+		kCoiflet1,
+		kCoiflet2,
+		kCoiflet3,
+		kCoiflet4,
+		kCoiflet5,
+		kBiorthogonal1_1,
+		kBiorthogonal1_3,
+		kBiorthogonal1_5,
+		kBiorthogonal2_2,
+		kBiorthogonal2_4,
+		kBiorthogonal2_6,
+		kBiorthogonal2_8,
+		kBiorthogonal3_1,
+		kBiorthogonal3_3,
+		kBiorthogonal3_5,
+		kBiorthogonal3_7,
+		kBiorthogonal3_9,
+		kBiorthogonal4_4,
+
+		kNumWavelets
+	};
+
+
+	// Filter lengths are available at compile time for HISSTools_Fixed_DWT (see HISSTools_Library_DWT below)
+
+	static constexpr unsigned long getLength(Type type)
+	{
+		return type <= kDaubechies20 ? 2 * (type - kHaar + 1) :
+			type <= kSymlet20 ? 2 * (type - kSymlet2 + 2) :
+			type <= kCoiflet5 ? 6 * (type - kCoiflet1 + 1) :
+			type == kBiorthogonal1_1 ? 2 :
+			type == kBiorthogonal1_3 ? 6 :
+			type == kBiorthogonal1_5 ? 10 :
+			type == kBiorthogonal2_2 ? 6 :
+			type == kBiorthogonal2_4 ? 10 :
+			type == kBiorthogonal2_6 ? 14 :
+			type == kBiorthogonal2_8 ? 18 :
+			type == kBiorthogonal3_1 ? 4 :
+			type == kBiorthogonal3_3 ? 8 :
+			type == kBiorthogonal3_5 ? 12 :
+			type == kBiorthogonal3_7 ? 16 :
+			type == kBiorthogonal3_9 ? 20 :
+			10;
+	}
+
+
+	static bool isOrthogonal(Type type)
+	{
+		return type < kBiorthogonal1_1;
+	}
+
+
+	static const char *getName(Type type)
+	{
+		return getEntry(type).mName;
+	}
+
+
+	// For orthogonal wavelets the inverse lowpass filter is the same as the forward lowpass filter
+
+	static const double *getForwardLoPass(Type type)
+	{
+		return getEntry(type).mForward;
+	}
+
+
+	static const double *getInverseLoPass(Type type)
+	{
+		return getEntry(type).mInverse ? getEntry(type).mInverse : getEntry(type).mForward;
+	}
+
+
+	// Set the filters of a wavelet (the highpass filters are derived by HISSTools_Wavelet)
+
+	static void setWavelet(HISSTools_Wavelet *wavelet, Type type, long offset = 0)
+	{
+		const Entry &entry = getEntry(type);
+
+		if (entry.mInverse)
+			wavelet->setBiorthogonalFilters(entry.mForward, entry.mInverse, entry.mLength, offset);
+		else
+		{
+			wavelet->setForwardFilters(entry.mForward, entry.mLength, offset);
+			wavelet->setInverseFilters();
+		}
+	}
+
+
+private:
+
+	struct Entry
+	{
+		const char *mName;
+		const double *mForward;
+		const double *mInverse;
+		unsigned long mLength;
+	};
+
+	static const Entry &getEntry(Type type)
+	{
+		static constexpr double haar[2] = {
+			0.7071067811865476, 0.7071067811865476};
+
+		static constexpr double db2[4] = {
+			-0.12940952255126037, 0.2241438680420134, 0.8365163037378079, 0.48296291314453416};
+
+		static constexpr double db3[6] = {
+			0.03522629188570953, -0.08544127388202666, -0.13501102001025458, 0.45987750211849154,
+			0.8068915093110925, 0.33267055295008263};
+
+		static constexpr double db4[8] = {
+			-0.010597401785069032, 0.0328830116668852, 0.030841381835560764, -0.18703481171909309,
+			-0.027983769416859854, 0.6308807679298589, 0.7148465705529157, 0.2303778133088965};
+
+		static constexpr double db5[10] = {
+			0.0033357252854737712, -0.012580751999081999, -0.006241490212798274, 0.07757149384004572,
+			-0.032244869584638375, -0.24229488706638203, 0.13842814590132074, 0.7243085284377729,
+			0.6038292697971896, 0.16010239797419293};
+
+		static constexpr double db6[12] = {
+			-0.0010773010853084796, 0.004777257510945511, 0.0005538422011614961, -0.03158203931748603,
+			0.027522865530305727, 0.09750160558732304, -0.12976686756726194, -0.22626469396543983,
+			0.31525035170919763, 0.7511339080210954, 0.49462389039845306, 0.11154074335010947};
+
+		static constexpr double db7[14] = {
+			0.00035371379997452024, -0.0018016407040474908, 0.0004295779729213665, 0.01255099855609984,
+			-0.01657454163066688, -0.03802993693501441, 0.08061260915108308, 0.07130921926683026,
+			-0.22403618499387498, -0.14390600392856498, 0.4697822874051931, 0.7291320908462351,
+			0.3965393194819173, 0.07785205408500918};
+
+		static constexpr double db8[16] = {
+			-0.00011747678412476953, 0.0006754494064505693, -0.00039174037337694705, -0.004870352993451574,
+			0.008746094047405777, 0.013981027917398282, -0.044088253930794755, -0.017369301001807547,
+			0.12874742662047847, 0.0004724845739132828, -0.2840155429615469, -0.015829105256349306,
+			0.5853546836542067, 0.6756307362972898, 0.31287159091429995, 0.05441584224310401};
+
+		static constexpr double db9[18] = {
+			3.93473203162716e-05, -0.0002519631889427101, 0.00023038576352319597, 0.0018476468830562265,
+			-0.00428150368246343, -0.004723204757751397, 0.022361662123679096, 0.00025094711483145197,
+			-0.06763282906132997, 0.03072568147933338, 0.14854074933810638, -0.09684078322297646,
+			-0.2932737832791749, 0.13319738582500756, 0.6572880780513005, 0.6048231236901112,
+			0.24383467461259034, 0.038077947363878345};
+
+		static constexpr double db10[20] = {
+			-1.3264202894521244e-05, 9.358867032006959e-05, -0.00011646685512928545, -0.0006858566949597116,
+			0.001992405295185056, 0.001395351747052901, -0.010733175483330575, 0.0036065535669561697,
+			0.033212674059341, -0.029457536821875813, -0.07139414716639708, 0.09305736460357235,
+			0.12736934033579325, -0.19594627437737705, -0.24984642432731538, 0.2811723436605775,
+			0.6884590394536035, 0.5272011889317256, 0.1881768000776915, 0.026670057900555554};
+
+		static constexpr double db11[22] = {
+			4.49427427723651e-06, -3.4634984186984996e-05, 5.4439074699368475e-05, 0.0002491525235528235,
+			-0.0008930232506662646, -0.0003085928588151432, 0.004928417656059041, -0.0033408588730144454,
+			-0.0153648209062016, 0.020840904360181062, 0.031335090219046076, -0.0664387856950252,
+			-0.046479955116684187, 0.14981201246637849, 0.0660435881966832, -0.27423084681794696,
+			-0.16227524502749036, 0.41196436894790744, 0.6856867749162006, 0.44989976435604534,
+			0.1440670211506245, 0.018694297761471083};
+
+		static constexpr double db12[24] = {
+			-1.529071758068511e-06, 1.2776952219379767e-05, -2.4241545757030785e-05, -8.850410920820432e-05,
+			0.00038865306282093143, 6.545128212509596e-06, -0.0021795036186277603, 0.0022486072409952378,
+			0.00671149900879551, -0.012840825198300683, -0.01221864906974828, 0.04154627749508444,
+			0.010849130255822185, -0.09643212009650708, 0.00535956967435215, 0.18247860592757967,
+			-0.023779257256069726, -0.3161784537527855, -0.04476388565377463, 0.5158864784278157,
+			0.6571987225793071, 0.37735513521421266, 0.10956627282118515, 0.013112257957229518};
+
+		static constexpr double db13[26] = {
+			5.220035098454864e-07, -4.700416479360868e-06, 1.0441930571408138e-05, 3.0678537579325496e-05,
+			-0.0001651289885565055, 4.9251525126289464e-05, 0.0009323261308672633, -0.001315673911892299,
+			-0.0027619112346568622, 0.007255589401617566, 0.003923941448797416, -0.02383142071032365,
+			0.0023799722540590786, 0.05613947710028343, -0.026488406475343694, -0.10580761818793433,
+			0.07294893365677717, 0.17947607942933985, -0.12457673075081525, -0.31497290771138864,
+			0.08698572617964724, 0.5888895704312189, 0.6110558511587877, 0.31199632216043804,
+			0.08286124387290278, 0.009202133538962367};
+
+		static constexpr double db14[28] = {
+			-1.7871399683113592e-07, 1.7249946753678127e-06, -4.389704901781394e-06, -1.0337209184570774e-05,
+			6.87550425269751e-05, -4.1777245770372596e-05, -0.0003868319473129545, 0.0007080211542355279,
+			0.001061691085606762, -0.0038496388680221874, -0.000746218989268385, 0.01278949326633341,
+			-0.005615049530356959, -0.030185351540390634, 0.026981408307912916, 0.05523712625921604,
+			-0.07154895550404614, -0.08674841156816969, 0.1399890165844607, 0.1383952138648066,
+			-0.21803352999327605, -0.27168855227874805, 0.21867068775890652, 0.6311878491048568,
+			0.5543056179408938, 0.2548502677926214, 0.0623647588493989, 0.006461153460087948};
+
+		static constexpr double db15[30] = {
+			6.133359913305752e-08, -6.316882325881664e-07, 1.8112704079405772e-06, 3.36298718173758e-06,
+			-2.8133296266047814e-05, 2.5792699155318936e-05, 0.00015589648992059973, -0.0003595652443624688,
+			-0.000373482354137617, 0.0019433239803822114, -0.00024175649076162427, -0.006487734560315745,
+			0.005101000360407543, 0.015083918027835902, -0.020810050169693083, -0.025767007328439964,
+			0.05478055058450761, 0.033877143923507685, -0.1111209360372317, -0.039666176555790945,
+			0.190146714007123, 0.06528295284877282, -0.28888259656696563, -0.19320413960914543,
+			0.3390025354547315, 0.6458131403574243, 0.4926317717081396, 0.20602386398699574,
+			0.04674339489276627, 0.004538537361578899};
+
+		static constexpr double db16[32] = {
+			-2.109339630100743e-08, 2.3087840868575457e-07, -7.363656785451205e-07, -1.0435713423116066e-06,
+			1.1336608661276258e-05, -1.3945668988208893e-05, -6.103596621410936e-05, 0.00017478724522533817,
+			0.00011424152003872239, -0.0009410217493595676, 0.00040789698084971285, 0.003128023381206269,
+			-0.00364427962149839, -0.006990014563413916, 0.013993768859828731, 0.01029765964095597,
+			-0.03688839769173014, -0.007588974368857738, 0.07592423604427631, -0.006239722752474872,
+			-0.1323883055638104, 0.027340263752716042, 0.2111906939471043, -0.027918208133028276,
+			-0.3270633105279177, -0.08975108940248964, 0.4402902568863569, 0.637356332083789,
+			0.4303127228460038, 0.16506428348885313, 0.034907714323673344, 0.003189220925347738};
+
+		static constexpr double db17[34] = {
+			7.2674929685616085e-09, -8.42394844600268e-08, 2.957700933316857e-07, 3.0165496099945573e-07,
+			-4.505942477222988e-06, 6.9906009850767515e-06, 2.3186813798745952e-05, -8.204803202453391e-05,
+			-2.5610109566548458e-05, 0.0004394654277686437, -0.00032813251940983797, -0.0014368453048029762,
+			0.0023012052421535457, 0.0029679966915260947, -0.008602921520322855, -0.003042989981354637,
+			0.02273367658394627, -0.0032709555358192938, -0.04692243838926974, 0.022312336178103798,
+			0.08110598665416088, -0.05709141963167693, -0.1268156917782863, 0.10113548917747027,
+			0.197310589565011, -0.1265997522158827, -0.32832074836396175, 0.027314970403293636,
+			0.5183157640569378, 0.6109966156846228, 0.37035072415264114, 0.1312149033078244,
+			0.025985393703606044, 0.0022418070010373128};
+
+		static constexpr double db18[36] = {
+			-2.5079344549485983e-09, 3.068835863045175e-08, -1.1760987670282317e-07, -7.691632689885177e-08,
+			1.7687129836276155e-06, -3.332634478885822e-06, -8.520602537446696e-06, 3.7412378807400385e-05,
+			-1.5359171235347246e-07, -0.00019864855231174796, 0.0002135815619103407, 0.0006284656829651457,
+			-0.0013405962983361066, -0.0011187326669924971, 0.004943343605466738, 0.00011863003385811746,
+			-0.013051480946612001, 0.006262167954305707, 0.02667070592647059, -0.023733210395860002,
+			-0.044526141902982326, 0.057051247738536884, 0.06488721621190545, -0.10675224665982849,
+			-0.09233188415084628, 0.1670813127632574, 0.14953397556537779, -0.21648093400514298,
+			-0.29365404073655876, 0.14722311196992816, 0.5718016548886513, 0.5718268077666072,
+			0.3146789413370317, 0.10358846582242359, 0.019288531724146376, 0.0015763102184407605};
+
+		static constexpr double db19[38] = {
+			8.666848838997619e-10, -1.1164020670358259e-08, 4.6369377757826045e-08, 1.4470882987978445e-08,
+			-6.862755657769143e-07, 1.531931476691193e-06, 3.0109643162965265e-06, -1.6640176297154945e-05,
+			5.105950487073886e-06, 8.711270467219923e-05, -0.00012460079173415878, -0.000260676135678628,
+			0.0007358025205054352, 0.00034180865345859575, -0.002687551800701582, 0.0007689543592575484,
+			0.007040747367105243, -0.005866922281012175, -0.013988388678535142, 0.019375549889176127,
+			0.02162376740958505, -0.04567422627723091, -0.02650123625012304, 0.08690675555581223,
+			0.027584350625628667, -0.1427856950387366, -0.03351854190230288, 0.21234974330627848,
+			0.07465226970810326, -0.28583863175582624, -0.22809139421548263, 0.26089495265103885,
+			0.6017045491275379, 0.5244363774646549, 0.26438843174089677, 0.08127811326545956,
+			0.014281098450764397, 0.0011086697631817106};
+
+		static constexpr double db20[40] = {
+			-2.9988364896193194e-10, 4.056127055551833e-09, -1.814843248299696e-08, 2.0143220235505126e-10,
+			2.6339242262700013e-07, -6.847079597000557e-07, -1.0119940100188862e-06, 7.2412482876736205e-06,
+			-4.376143862183997e-06, -3.710586183394713e-05, 6.77428082837773e-05, 0.00010153288973670291,
+			-0.00038510474869921763, -5.349759843997695e-05, 0.0013925596193231364, -0.0008315621728225569,
+			-0.0035814942596096226, 0.004420542387045791, 0.006721627302259457, -0.01381052613715192,
+			-0.00878932492390156, 0.03229429953076958, 0.005874681811811827, -0.06172289962468046,
+			0.005632246857307436, 0.10229171917444256, -0.024716827338613585, -0.15545875070726795,
+			0.0398502464577712, 0.22829105081991632, -0.016727088309077008, -0.32678680043403496,
+			-0.13921208801148388, 0.36150229873933104, 0.6104932389385939, 0.4726961853109017,
+			0.21994211355139703, 0.06342378045908152, 0.010549394624950399, 0.0007799536136668463};
+
+		static constexpr double sym2[4] = {
+			0.48296291314453416, 0.8365163037378079, 0.2241438680420134, -0.12940952255126037};
+
+		static constexpr double sym3[6] = {
+			0.33267055295008263, 0.8068915093110925, 0.45987750211849154, -0.13501102001025458,
+			-0.08544127388202666, 0.03522629188570953};
+
+		static constexpr double sym4[8] = {
+			-0.07576571478950221, -0.029635527646002493, 0.497618667632775, 0.8037387518051321,
+			0.29785779560530606, -0.09921954357663353, -0.012603967262031304, 0.032223100604051466};
+
+		static constexpr double sym5[10] = {
+			0.027333068344998768, 0.02951949092570626, -0.039134249302313844, 0.19939753397685558,
+			0.7234076904040407, 0.633978963456792, 0.01660210576451085, -0.17532808990805623,
+			-0.021101834024689042, 0.019538882735249827};
+
+		static constexpr double sym6[12] = {
+			0.015404109327044824, 0.0034907120842221626, -0.11799011114852002, -0.04831174258569806,
+			0.49105594192797375, 0.787641141028651, 0.3379294217281658, -0.07263752278637658,
+			-0.02106029251237085, 0.04472490177078139, 0.0017677118642540077, -0.00780070832503238};
+
+		static constexpr double sym7[14] = {
+			0.010268176708464817, 0.0040102448715223955, -0.10780823770328972, -0.14004724044293365,
+			0.2886296317506479, 0.7677643170048829, 0.5361019170905692, 0.017441255086835708,
+			-0.04955283493704283, 0.06789269350122057, 0.030515513165877885, -0.012636303403240567,
+			-0.001047384888679738, 0.002681814568260147};
+
+		static constexpr double sym8[16] = {
+			-0.0033824159510050028, -0.0005421323318000107, 0.03169508781152599, 0.007607487324976609,
+			-0.14329423835127267, -0.061273359067811076, 0.4813596512590534, 0.777185751699628,
+			0.36444189483617895, -0.0519458381078818, -0.027219029917103486, 0.04913717967373029,
+			0.0038087520138944896, -0.014952258337062199, -0.0003029205147241331, 0.001889950332767689};
+
+		static constexpr double sym9[18] = {
+			0.0014009155259146562, 0.0006197808889855071, -0.013271967781817134, -0.011528210207679187,
+			0.030224878858275187, 0.0005834627461249819, -0.05456895843083335, 0.23876091460730517,
+			0.7178970827644124, 0.6173384491409342, 0.03527248803527104, -0.19155083129728434,
+			-0.018233770779395506, 0.062077789302885746, 0.008859267493400267, -0.010264064027633121,
+			-0.00047315449868004354, 0.001069490032908612};
+
+		static constexpr double sym10[20] = {
+			0.0007701598091144599, 9.563267072285273e-05, -0.00864129927702215, -0.0014653825813046104,
+			0.04592723923109151, 0.011609893903711319, -0.1594942788849106, -0.07088053578323157,
+			0.4716906669384429, 0.7695100370210979, 0.3838267610670763, -0.035536740473819585,
+			-0.03199005688242811, 0.049994972077375154, 0.00576491203358115, -0.02035493981231111,
+			-0.0008043589320164513, 0.004593173585311792, 5.703608361849501e-05, -0.00045932942100465206};
+
+		static constexpr double sym11[22] = {
+			0.0004606305605148373, -7.65772449580718e-05, -0.006771448704106258, -0.0019612949999627516,
+			0.04376901650963226, 0.03305858716684881, -0.15780577401669701, -0.2318019545195779,
+			0.2079334318996007, 0.716393134437828, 0.5812488825406404, 0.1197689799624749,
+			-0.0014103525839676686, 0.08424075350641098, 0.045806026757461774, -0.01868001745577665,
+			-0.007119110903185566, 0.007529950423726059, 0.0009651567686634688, -0.0015471763723506476,
+			3.032235799056933e-05, 0.00018239628188471723};
+
+		static constexpr double sym12[24] = {
+			-0.00017906658697508447, -1.8158078862632958e-05, 0.0023502976141833473, 0.00030764779631052455,
+			-0.014589836449233534, -0.002604391031331419, 0.05780417944550475, 0.015301740622480154,
+			-0.17037069723884962, -0.07833262231631544, 0.46274103121928645, 0.7634790977836405,
+			0.398885972390192, -0.022162306170351302, -0.035848830736954634, 0.0491793182996612,
+			0.007553780611679315, -0.024220722675013403, -0.001408909244329129, 0.007414965517654315,
+			0.00018021409008521752, -0.001349755755571579, -1.1353928041526612e-05, 0.00011196719424656528};
+
+		static constexpr double sym13[26] = {
+			6.820325263074355e-05, -3.573862364871594e-05, -0.001136063438927969, -0.00017094285852957213,
+			0.00752622538996817, 0.005296359738721862, -0.020216768133395468, -0.017211642726304387,
+			0.01386249743583841, -0.059750627717956466, -0.12436246075150338, 0.19770481877126597,
+			0.6957391505615691, 0.6445643839011571, 0.11023022302128688, -0.14049009311367552,
+			0.008819757670429852, 0.09292603089914397, 0.017618296880645045, -0.020749686325520652,
+			-0.0014924472742587286, 0.005674853760123338, 0.0004132611988416782, -0.0007213643851363755,
+			3.690537342323894e-05, 7.042986690696273e-05};
+
+		static constexpr double sym14[28] = {
+			4.220014320785332e-05, 3.6172557736156147e-06, -0.0006354851881322328, -6.766044627562865e-05,
+			0.004537697585299536, 0.0006235203122978512, -0.02058458283744137, -0.0038492742355031944,
+			0.06761685109309754, 0.018650326535643823, -0.17792194589276836, -0.08430768294615623,
+			0.45461693898982086, 0.7585322647669023, 0.41107149065583304, -0.010996383074838904,
+			-0.03906858665270088, 0.04755098184775846, 0.00916928316390243, -0.026916568572214482,
+			-0.0020574605441176313, 0.010043011989769748, 0.0003596426725397825, -0.0025176508186993784,
+			-4.160741858341911e-05, 0.0003856410043283668, 2.345416590374714e-06, -2.736243223877862e-05};
+
+		static constexpr double sym15[30] = {
+			2.421024521816031e-05, -5.0077106135514165e-06, -0.0004288916851548535, 2.8704974585757638e-05,
+			0.0037073834912975533, 0.0007446590555099679, -0.019665344418785383, -0.00969505264691475,
+			0.07198842931674558, 0.06676788592614434, -0.16722992228336517, -0.2727231502265923,
+			0.15627021427911547, 0.676847218461176, 0.6017476220060985, 0.17801313149997924,
+			0.02557669883771275, 0.08548859440538066, 0.04723482318984018, -0.025623245712566977,
+			-0.014456868629651913, 0.010333830120957618, 0.0027429643222761143, -0.003851748675707289,
+			-0.0004035697194514467, 0.0009234203705140214, -3.3460027921826616e-06, -0.00015395646661098698,
+			2.3782374440991734e-06, 1.149781130579714e-05};
+
+		static constexpr double sym16[32] = {
+			-1.0039160092106442e-05, -7.453525766266454e-07, 0.00017075757033576904, 1.5310735368875494e-05,
+			-0.0013821075359883772, -0.00015397741144276744, 0.007111471869857564, 0.001021764336646459,
+			-0.026315035474720194, -0.005132825563984341, 0.07573691820820833, 0.02167441628561381,
+			-0.1832876555107199, -0.08922063809143883, 0.4472682714087321, 0.7543524599810609,
+			0.42122506605464877, -0.0014883315308900395, -0.04181879051330824, 0.0455346281866865,
+			0.010626580114659839, -0.028752329227440948, -0.0027161342842907223, 0.012364761246703831,
+			0.0005814968274997711, -0.003822225760374699, -9.329971738961008e-05, 0.0008158530109080309,
+			9.778834875948431e-06, -0.00010804056755718613, -4.975057614655637e-07, 6.700909264582751e-06};
+
+		static constexpr double sym17[34] = {
+			3.7912531943316247e-06, -2.4527163425740825e-06, -7.607124405602918e-05, 2.5207933140671322e-05,
+			0.0007198270642145453, 5.840042869518092e-05, -0.003932325279794941, -0.0019054076898564055,
+			0.012396988366634302, 0.009952982523507613, -0.01803889724190139, -0.007261634750933915,
+			0.01615880872591857, -0.08607087472063264, -0.1550760053497069, 0.18053958458074407,
+			0.681488995344317, 0.6507166292043823, 0.1423983504151139, -0.11856693261099856,
+			0.01727117821060019, 0.10475461484219489, 0.01790395221438949, -0.03329138349230622,
+			-0.004819212803181354, 0.010482366933016147, 0.0008567700701928022, -0.0027416759756781813,
+			-0.00013864230268101327, 0.00047599638026318304, -1.3506383399799107e-05, -6.293702597545909e-05,
+			2.780126693825943e-06, 4.297343327338256e-06};
+
+		static constexpr double sym18[36] = {
+			2.485961490308411e-06, 6.729793997408882e-07, -4.500780415588217e-05, -5.793109601174063e-06,
+			0.00041034842990739044, 5.672412058691769e-05, -0.0023411772447689224, -0.0002756861706489776,
+			0.009856762134333768, 0.0017192429181093615, -0.03085612629494498, -0.005371485930637385,
+			0.08395338201053697, 0.028758420486383298, -0.17673219236417814, -0.07816993032151809,
+			0.45292937921867643, 0.7523858568035735, 0.420296170314231, -0.007290779523199082,
+			-0.05561401457831262, 0.03672015801081675, 0.008596398059412116, -0.03158443807938197,
+			-0.003958415362757906, 0.01425104836988376, 0.0007708733438240781, -0.00524468783976525,
+			-0.00019016900992115926, 0.001387216955292587, 3.172057444776149e-05, -0.0002582924341688838,
+			-4.066698986845518e-06, 3.0124194362197284e-05, 4.3049771415368917e-07, -1.5902429397748582e-06};
+
+		static constexpr double sym19[38] = {
+			1.4224109815546573e-06, 1.7505280479122197e-09, -2.9848079023704324e-05, -3.185451666730451e-06,
+			0.00029472014007215765, 4.4612854719308106e-05, -0.001888112579165604, -0.0004009132810358546,
+			0.008975678778654114, 0.003402236823012579, -0.032391307449362985, -0.021737338713066483,
+			0.08392497625316736, 0.08666021733180766, -0.15895973641585182, -0.2669311707406808,
+			0.15668672745649775, 0.6689413319120553, 0.6085069346664966, 0.19268630215083848,
+			0.017744113312349975, 0.06644351247518779, 0.03769279754470035, -0.032696784891697944,
+			-0.01893990345962711, 0.014539847758961449, 0.006472377454143769, -0.0054143645354044435,
+			-0.001116311693207969, 0.0020485762586906708, 0.00014762264079737236, -0.0005719896320582272,
+			-1.687940058814816e-05, 0.00010746087075460964, 1.5104368607290924e-06, -1.224727457984906e-05,
+			-8.313469459030021e-10, 6.7552018189294e-07};
+
+		static constexpr double sym20[40] = {
+			-6.060783323267337e-07, -1.9898068316230918e-07, 1.203307277542689e-05, 2.1169769491787713e-06,
+			-0.00011994333166061282, -1.6677870141445577e-05, 0.0007663683300953469, 9.956735583217703e-05,
+			-0.0035261348627234966, -0.0004553576009665967, 0.012629544684414584, 0.0022256981192845765,
+			-0.03552131159028303, -0.006363296386410459, 0.08994810497246514, 0.032702001711966036,
+			-0.17557919777208245, -0.0756961810496387, 0.4518458919126966, 0.7499791684334408,
+			0.42397009037220773, -0.005820090143509892, -0.062384578089837356, 0.03197138718121244,
+			0.008786603795269025, -0.032645018939176124, -0.004590504910028372, 0.016037956388587758,
+			0.0010893265376331486, -0.00656387577378153, -0.00027287079876992334, 0.002056484229982501,
+			6.265510187839038e-05, -0.00047843848966187553, -1.0075168706661135e-05, 7.931081554559506e-05,
+			1.5117090543954294e-06, -8.160708300277826e-06, -1.266995180441895e-07, 3.859160164817888e-07};
+
+		static constexpr double coif1[6] = {
+			-0.015655728135791993, -0.07273261951252645, 0.3848648468648577, 0.8525720202116004,
+			0.33789766245748176, -0.07273261951252645};
+
+		static constexpr double coif2[12] = {
+			-0.000720549445520347, -0.001823208870911032, 0.005611434819368834, 0.02368017194684777,
+			-0.059434418646431085, -0.07648859907828076, 0.41700518442323903, 0.8127236354494135,
+			0.38611006682276283, -0.0673725547237256, -0.04146493678687178, 0.01638733646320364};
+
+		static constexpr double coif3[18] = {
+			-3.4599773197272774e-05, -7.0983302506379e-05, 0.0004662169598204029, 0.0011175187708306303,
+			-0.002574517688136797, -0.009007976136730624, 0.015880544863669452, 0.03455502757329773,
+			-0.08230192710629981, -0.07179982161915484, 0.42848347637737, 0.7937772226260872,
+			0.4051769024091182, -0.06112339000297254, -0.06577191128146936, 0.023452696142077165,
+			0.0077825964256727454, -0.0037935128643808015};
+
+		static constexpr double coif4[24] = {
+			-1.7849909144933466e-06, -3.2596479400307506e-06, 3.1229861599195265e-05, 6.233885431278718e-05,
+			-0.0002599743371222568, -0.0005890202246332164, 0.0012665610789256603, 0.003751434697146086,
+			-0.0056582838001308835, -0.015211728187697211, 0.025082253337949608, 0.03933442260558915,
+			-0.09622042453595264, -0.06662747236681715, 0.43438603311435653, 0.7822389344242826,
+			0.41530842700068227, -0.05607731960356926, -0.08126671024919373, 0.026682304669604834,
+			0.016068947131575025, -0.00734616793626805, -0.0016294924252267858, 0.000892313902537003};
+
+		static constexpr double coif5[30] = {
+			-9.604010112767892e-08, -1.6237995172048335e-07, 2.0612203985788783e-06, 3.7007277113394796e-06,
+			-2.1270221672515614e-05, -4.12198619242655e-05, 0.00014035632812373243, 0.00030185794166824473,
+			-0.0006375589261258812, -0.0016616273039298788, 0.0024315754425382886, 0.006761520220620417,
+			-0.009159507338676163, -0.019758391600965465, 0.03267479946705735, 0.041287530472117834,
+			-0.10556315130733723, -0.06203775157498195, 0.4379823066591633, 0.7742936228603274,
+			0.42157126673075435, -0.05204667025355476, -0.09192158806008609, 0.028169744270532353,
+			0.023408322118927783, -0.010131584846900275, -0.004159312627578639, 0.0021782943778456947,
+			0.0003585777411617577, -0.000212081862067494};
+
+		static constexpr double bior1_1Forward[2] = {
+			0.7071067811865476, 0.7071067811865476};
+		static constexpr double bior1_1Inverse[2] = {
+			0.7071067811865476, 0.7071067811865476};
+
+		static constexpr double bior1_3Forward[6] = {
+			-0.08838834764831845, 0.08838834764831845, 0.7071067811865476, 0.7071067811865476,
+			0.08838834764831845, -0.08838834764831845};
+		static constexpr double bior1_3Inverse[6] = {
+			0.0, 0.0, 0.7071067811865476, 0.7071067811865476,
+			0.0, 0.0};
+
+		static constexpr double bior1_5Forward[10] = {
+			0.016572815184059706, -0.016572815184059706, -0.12153397801643785, 0.12153397801643785,
+			0.7071067811865476, 0.7071067811865476, 0.12153397801643785, -0.12153397801643785,
+			-0.016572815184059706, 0.016572815184059706};
+		static constexpr double bior1_5Inverse[10] = {
+			0.0, 0.0, 0.0, 0.0,
+			0.7071067811865476, 0.7071067811865476, 0.0, 0.0,
+			0.0, 0.0};
+
+		static constexpr double bior2_2Forward[6] = {
+			0.0, -0.1767766952966369, 0.3535533905932738, 1.0606601717798212,
+			0.3535533905932738, -0.1767766952966369};
+		static constexpr double bior2_2Inverse[6] = {
+			0.0, 0.0, 0.3535533905932738, 0.7071067811865476,
+			0.3535533905932738, 0.0};
+
+		static constexpr double bior2_4Forward[10] = {
+			0.0, 0.03314563036811941, -0.06629126073623882, -0.1767766952966369,
+			0.4198446513295126, 0.9943689110435825, 0.4198446513295126, -0.1767766952966369,
+			-0.06629126073623882, 0.03314563036811941};
+		static constexpr double bior2_4Inverse[10] = {
+			0.0, 0.0, 0.0, 0.0,
+			0.3535533905932738, 0.7071067811865476, 0.3535533905932738, 0.0,
+			0.0, 0.0};
+
+		static constexpr double bior2_6Forward[14] = {
+			0.0, -0.006905339660024878, 0.013810679320049757, 0.04695630968816917,
+			-0.1077232986963881, -0.16987135563661201, 0.4474660099696121, 0.966747552403483,
+			0.4474660099696121, -0.16987135563661201, -0.1077232986963881, 0.04695630968816917,
+			0.013810679320049757, -0.006905339660024878};
+		static constexpr double bior2_6Inverse[14] = {
+			0.0, 0.0, 0.0, 0.0,
+			0.0, 0.0, 0.3535533905932738, 0.7071067811865476,
+			0.3535533905932738, 0.0, 0.0, 0.0,
+			0.0, 0.0};
+
+		static constexpr double bior2_8Forward[18] = {
+			0.0, 0.0015105430506304422, -0.0030210861012608843, -0.012947511862546647,
+			0.02891610982635418, 0.05299848189069094, -0.13491307360773605, -0.16382918343409023,
+			0.46257144047591653, 0.9516421218971786, 0.46257144047591653, -0.16382918343409023,
+			-0.13491307360773605, 0.05299848189069094, 0.02891610982635418, -0.012947511862546647,
+			-0.0030210861012608843, 0.0015105430506304422};
+		static constexpr double bior2_8Inverse[18] = {
+			0.0, 0.0, 0.0, 0.0,
+			0.0, 0.0, 0.0, 0.0,
+			0.3535533905932738, 0.7071067811865476, 0.3535533905932738, 0.0,
+			0.0, 0.0, 0.0, 0.0,
+			0.0, 0.0};
+
+		static constexpr double bior3_1Forward[4] = {
+			-0.3535533905932738, 1.0606601717798212, 1.0606601717798212, -0.3535533905932738};
+		static constexpr double bior3_1Inverse[4] = {
+			0.1767766952966369, 0.5303300858899106, 0.5303300858899106, 0.1767766952966369};
+
+		static constexpr double bior3_3Forward[8] = {
+			0.06629126073623882, -0.1988737822087165, -0.15467960838455727, 0.9943689110435825,
+			0.9943689110435825, -0.15467960838455727, -0.1988737822087165, 0.06629126073623882};
+		static constexpr double bior3_3Inverse[8] = {
+			0.0, 0.0, 0.1767766952966369, 0.5303300858899106,
+			0.5303300858899106, 0.1767766952966369, 0.0, 0.0};
+
+		static constexpr double bior3_5Forward[12] = {
+			-0.013810679320049757, 0.04143203796014927, 0.052480581416189075, -0.26792717880896527,
+			-0.07181553246425873, 0.966747552403483, 0.966747552403483, -0.07181553246425873,
+			-0.26792717880896527, 0.052480581416189075, 0.04143203796014927, -0.013810679320049757};
+		static constexpr double bior3_5Inverse[12] = {
+			0.0, 0.0, 0.0, 0.0,
+			0.1767766952966369, 0.5303300858899106, 0.5303300858899106, 0.1767766952966369,
+			0.0, 0.0, 0.0, 0.0};
+
+		static constexpr double bior3_7Forward[16] = {
+			0.0030210861012608843, -0.009063258303782653, -0.01683176542131064, 0.074663985074019,
+			0.03133297870736289, -0.301159125922835, -0.02649924094534547, 0.9516421218971786,
+			0.9516421218971786, -0.02649924094534547, -0.301159125922835, 0.03133297870736289,
+			0.074663985074019, -0.01683176542131064, -0.009063258303782653, 0.0030210861012608843};
+		static constexpr double bior3_7Inverse[16] = {
+			0.0, 0.0, 0.0, 0.0,
+			0.0, 0.0, 0.1767766952966369, 0.5303300858899106,
+			0.5303300858899106, 0.1767766952966369, 0.0, 0.0,
+			0.0, 0.0, 0.0, 0.0};
+
+		static constexpr double bior3_9Forward[20] = {
+			-0.0006797443727836989, 0.002039233118351097, 0.005060319219611981, -0.020618912641105536,
+			-0.014112787930175844, 0.09913478249423216, 0.012300136269419315, -0.32019196836077857,
+			0.0020500227115698858, 0.9421257006782068, 0.9421257006782068, 0.0020500227115698858,
+			-0.32019196836077857, 0.012300136269419315, 0.09913478249423216, -0.014112787930175844,
+			-0.020618912641105536, 0.005060319219611981, 0.002039233118351097, -0.0006797443727836989};
+		static constexpr double bior3_9Inverse[20] = {
+			0.0, 0.0, 0.0, 0.0,
+			0.0, 0.0, 0.0, 0.0,
+			0.1767766952966369, 0.5303300858899106, 0.5303300858899106, 0.1767766952966369,
+			0.0, 0.0, 0.0, 0.0,
+			0.0, 0.0, 0.0, 0.0};
+
+		static constexpr double bior4_4Forward[10] = {
+			0.0, 0.03782845550699546, -0.02384946501938, -0.1106244044184234,
+			0.37740285561265374, 0.8526986790094034, 0.37740285561265374, -0.1106244044184234,
+			-0.02384946501938, 0.03782845550699546};
+		static constexpr double bior4_4Inverse[10] = {
+			0.0, 0.0, -0.06453888262893843, -0.04068941760955844,
+			0.4180922732222122, 0.7884856164056644, 0.4180922732222122, -0.04068941760955844,
+			-0.06453888262893843, 0.0};
+
+		static const Entry entries[kNumWavelets] = {
+			{"haar", haar, NULL, 2},
+			{"db2", db2, NULL, 4},
+			{"db3", db3, NULL, 6},
+			{"db4", db4, NULL, 8},
+			{"db5", db5, NULL, 10},
+			{"db6", db6, NULL, 12},
+			{"db7", db7, NULL, 14},
+			{"db8", db8, NULL, 16},
+			{"db9", db9, NULL, 18},
+			{"db10", db10, NULL, 20},
+			{"db11", db11, NULL, 22},
+			{"db12", db12, NULL, 24},
+			{"db13", db13, NULL, 26},
+			{"db14", db14, NULL, 28},
+			{"db15", db15, NULL, 30},
+			{"db16", db16, NULL, 32},
+			{"db17", db17, NULL, 34},
+			{"db18", db18, NULL, 36},
+			{"db19", db19, NULL, 38},
+			{"db20", db20, NULL, 40},
+			{"sym2", sym2, NULL, 4},
+			{"sym3", sym3, NULL, 6},
+			{"sym4", sym4, NULL, 8},
+			{"sym5", sym5, NULL, 10},
+			{"sym6", sym6, NULL, 12},
+			{"sym7", sym7, NULL, 14},
+			{"sym8", sym8, NULL, 16},
+			{"sym9", sym9, NULL, 18},
+			{"sym10", sym10, NULL, 20},
+			{"sym11", sym11, NULL, 22},
+			{"sym12", sym12, NULL, 24},
+			{"sym13", sym13, NULL, 26},
+			{"sym14", sym14, NULL, 28},
+			{"sym15", sym15, NULL, 30},
+			{"sym16", sym16, NULL, 32},
+			{"sym17", sym17, NULL, 34},
+			{"sym18", sym18, NULL, 36},
+			{"sym19", sym19, NULL, 38},
+			{"sym20", sym20, NULL, 40},
+			{"coif1", coif1, NULL, 6},
+			{"coif2", coif2, NULL, 12},
+			{"coif3", coif3, NULL, 18},
+			{"coif4", coif4, NULL, 24},
+			{"coif5", coif5, NULL, 30},
+			{"bior1.1", bior1_1Forward, bior1_1Inverse, 2},
+			{"bior1.3", bior1_3Forward, bior1_3Inverse, 6},
+			{"bior1.5", bior1_5Forward, bior1_5Inverse, 10},
+			{"bior2.2", bior2_2Forward, bior2_2Inverse, 6},
+			{"bior2.4", bior2_4Forward, bior2_4Inverse, 10},
+			{"bior2.6", bior2_6Forward, bior2_6Inverse, 14},
+			{"bior2.8", bior2_8Forward, bior2_8Inverse, 18},
+			{"bior3.1", bior3_1Forward, bior3_1Inverse, 4},
+			{"bior3.3", bior3_3Forward, bior3_3Inverse, 8},
+			{"bior3.5", bior3_5Forward, bior3_5Inverse, 12},
+			{"bior3.7", bior3_7Forward, bior3_7Inverse, 16},
+			{"bior3.9", bior3_9Forward, bior3_9Inverse, 20},
+			{"bior4.4", bior4_4Forward, bior4_4Inverse, 10}};
+
+		return entries[type < kNumWavelets ? type : kHaar];
+	}
+};
+
+
+// A fixed length DWT for a wavelet from the library (for example HISSTools_Library_DWT<HISSTools_Wavelet_Library::kDaubechies4>)
+
+template <HISSTools_Wavelet_Library::Type T>
+class HISSTools_Library_DWT : public HISSTools_Fixed_DWT<HISSTools_Wavelet_Library::getLength(T)>
+{
+
+public:
+
+	HISSTools_Library_DWT(unsigned long maxLength, long offset = 0)
+	: HISSTools_Fixed_DWT<HISSTools_Wavelet_Library::getLength(T)>(maxLength)
+	{
+		HISSTools_Wavelet wavelet;
+
+		HISSTools_Wavelet_Library::setWavelet(&wavelet, T, offset);
+		this->setWavelet(&wavelet);
+	}
+};
+
+
+#endif
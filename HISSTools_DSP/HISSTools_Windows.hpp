@@ -5,6 +5,16 @@
 
 
 #include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <vector>
+#include "HISSTools_SIMD.hpp"
+#include "../HISSTools_Utility/HISSTools_ThreadSafety.hpp"
 
 
 #define WIND_PI				3.14159265358979323846
@@ -29,6 +39,9 @@ enum WindowTypes {
 	WIND_BLACKMAN_HARRIS = 10,
 	WIND_FLAT_TOP = 11,
 	WIND_RECT = 12,
+	WIND_TUKEY = 13,
+	WIND_DPSS = 14,
+	WIND_COSINE_SUM = 15,
 };
 
 
@@ -40,77 +53,93 @@ enum GainTypes {
 	WIND_SQ_OVER_LIN_GAIN = 3,
 };
 
-class HISSTools_Windows
+// Parameters for the parameterised window types (values that are not set take the default given)
+
+// WIND_KAISER		- value 0 is alpha (6.8)
+// WIND_TUKEY		- value 0 is the tapered fraction of the window from 0 (rectangular) to 1 (von Hann) (0.5)
+// WIND_DPSS		- value 0 is the time-bandwidth product NW (3)
+// WIND_COSINE_SUM	- values are the coefficients of a0 - a1 * cos(x) + a2 * cos(2x) - a3 * cos(3x)... (von Hann)
+
+struct HISSTools_Window_Params
 {
+	static const unsigned long kMaxValues = 8;
 	
-public:
-	
-	HISSTools_Windows(unsigned long maxwindowSize) 
+	HISSTools_Window_Params() : mNValues(0)
 	{
-		if (maxwindowSize < 1)
-			maxwindowSize = 1;
-		
-		mWindow = new double[maxwindowSize];	
-		
-		if (mWindow)
-			mMaxWindowSize = maxwindowSize;
-		else
-			mMaxWindowSize = 0;
-		
-		// Force calculation on the first call
-		
-		mWindowSize = -1;			
-	};
+		for (unsigned long i = 0; i < kMaxValues; i++)
+			mValues[i] = 0.0;
+	}
 	
+	HISSTools_Window_Params(double value) : mNValues(1)
+	{
+		for (unsigned long i = 0; i < kMaxValues; i++)
+			mValues[i] = i ? 0.0 : value;
+	}
 	
-	~HISSTools_Windows() 
+	HISSTools_Window_Params(const double *values, unsigned long nValues) : mNValues(nValues > kMaxValues ? kMaxValues : nValues)
 	{
-		delete[] mWindow;
-	};
+		for (unsigned long i = 0; i < kMaxValues; i++)
+			mValues[i] = i < mNValues ? values[i] : 0.0;
+	}
 	
+	double get(unsigned long idx, double defaultValue) const
+	{
+		return idx < mNValues ? mValues[idx] : defaultValue;
+	}
 	
-	bool applyWindow(double *in, double *out, WindowTypes windowType, unsigned long windowSize, bool sqrtWindow, double fixedGain, GainTypes compensateWindowGain)
+	bool operator == (const HISSTools_Window_Params& b) const
 	{
-		double *window = mWindow;
-		double gain = fixedGain;
-		
-		// Sanity Check
-
-		if (windowSize > mMaxWindowSize)
+		if (mNValues != b.mNValues)
 			return false;
 		
-		if (windowSize != mWindowSize || windowType != mWindowType || sqrtWindow != mSqrtWindow)
-			calculateWindow(windowSize, windowType, sqrtWindow);
-		
-		if (compensateWindowGain == WIND_LIN_GAIN)
-			gain /= mWindowLinGain;
-		if (compensateWindowGain == WIND_SQ_GAIN)
-			gain /= mWindowSqGain;
-		if (compensateWindowGain == WIND_SQ_OVER_LIN_GAIN)
-			gain /= (mWindowSqGain / mWindowLinGain);
-		
-		for (long i = 0; i < windowSize; i++)
-			out[i] = in[i] * window[i] * gain;
+		for (unsigned long i = 0; i < mNValues; i++)
+			if (mValues[i] != b.mValues[i])
+				return false;
 		
 		return true;
 	}
 	
+	bool operator != (const HISSTools_Window_Params& b) const
+	{
+		return !(*this == b);
+	}
 	
-	void applyWindow(double *io, WindowTypes windowType, unsigned long windowSize, bool sqrtWindow, double fixedGain, GainTypes compensateWindowGain)
+	unsigned long hash() const
 	{
-		applyWindow(io, io, windowType, windowSize, sqrtWindow, fixedGain, compensateWindowGain);
+		uint64_t key = mNValues;
+		
+		for (unsigned long i = 0; i < mNValues; i++)
+		{
+			uint64_t bits;
+			memcpy(&bits, &mValues[i], sizeof(uint64_t));
+			key = (key ^ bits) * 1099511628211ULL;
+		}
+		
+		return (unsigned long) (key ^ (key >> 32));
 	}
 	
+	double mValues[kMaxValues];
+	unsigned long mNValues;
+};
+
+
+// Window calculation (shared by instances and the cache)
+
+class HISSTools_Window_Functions
+{
 	
-private:
+public:
+	
+	// Modified Bessel function of the first kind (order zero) for an argument of sqrt(xSq)
+	// The series is stopped once a term no longer changes the sum (relative accuracy ~1e-16)
 	
-	double IZero(double xSq)
+	static double IZero(double xSq)
 	{
 		unsigned long i;
 		double newTerm = 1;
 		double bFunction = 1;
 		
-		for (i = 1; newTerm; i++)		// Gives Maximum Accuracy
+		for (i = 1; newTerm > bFunction * 1e-17; i++)
 		{
 			newTerm = newTerm * xSq * (1.0 / (4.0 * (double) i * (double) i));
 			bFunction += newTerm;
@@ -120,11 +149,9 @@ private:
 	}
 	
 	
-	void calculateWindow(unsigned long windowSize, WindowTypes windowType, long sqrtWindow)
+	static void calculate(double *window, unsigned long windowSize, WindowTypes windowType, bool sqrtWindow, double &windowLinGain, double &windowSqGain, const HISSTools_Window_Params &params = HISSTools_Window_Params())
 	{
-		double *window = mWindow;
-		
-		double windowLinGain, windowSqGain, alpha, alphaBesselRecip, xSq, val;
+		double alpha, alphaBesselRecip, xSq, val, ratio;
 		
 		long halfWindowSize = windowSize >> 1;
 		unsigned long i;
@@ -132,30 +159,30 @@ private:
 		switch (windowType)
 		{
 			case WIND_VON_HANN:
-				for (i = 0; i < windowSize; i++)
-					window[i] = 0.5 - (0.5 * cos(WIND_TWOPI * ((double) i / (double) windowSize)));
+				cosineSum(window, windowSize, 0.5, 0.5);
 				break;
 				
 			case WIND_HAMMING:
-				for (i = 0; i < windowSize; i++)
-					window[i] = 0.54347826 - (0.45652174 * cos(WIND_TWOPI * ((double) i / (double) windowSize)));
+				cosineSum(window, windowSize, 0.54347826, 0.45652174);
 				break;
 				
 			case WIND_KAISER:
 				
 				// First find bessel function of alpha
 				
-				alpha = 6.8;
+				alpha = params.get(0, 6.8);
 				alphaBesselRecip = 1. / IZero(alpha * alpha);
-								
-				for (i = 0; i < windowSize; i++)
+				
+				// Kaiser window (symmetric about halfWindowSize so only the first half is calculated - for odd sizes that is not size / 2)
+				
+				for (i = 0; i <= (unsigned long) halfWindowSize && i < windowSize; i++)
 				{
-					// Kaiser window
-					
 					val = ((double) i - halfWindowSize) / (double) halfWindowSize;
 					xSq = (1.0 - val * val) * alpha * alpha;		
 					window[i] = IZero(xSq) * alphaBesselRecip;
 				}
+				for (; i < windowSize; i++)
+					window[i] = window[2 * halfWindowSize - i];
 				break;
 				
 			case WIND_TRIANGLE:
@@ -166,49 +193,66 @@ private:
 				break;
 				
 			case WIND_COSINE:
-				for (i = 0; i < windowSize; i++)
+				for (i = 0; i <= (windowSize >> 1) && i < windowSize; i++)
 					window[i] = sin(WIND_PI * ((double) i / (double) windowSize));
+				for (; i < windowSize; i++)
+					window[i] = window[windowSize - i];
 				break;
 				
 			case WIND_BLACKMAN:
-				for (i = 0; i < windowSize; i++)
-					window[i] = 0.42659071 - (0.49656062 * cos(WIND_TWOPI * ((double) i / (double) windowSize))) + (0.07684867 * cos(WIND_FOURPI * ((double) i / (double) windowSize)));
+				cosineSum(window, windowSize, 0.42659071, 0.49656062, 0.07684867);
 				break;
 				
 			case WIND_BLACKMAN_62:
-				for (i = 0; i < windowSize; i++)
-					window[i] = (0.44859f - 0.49364f * cos(WIND_TWOPI * ((double) i / (double) windowSize)) + 0.05677f * cos(WIND_FOURPI * ((double) i / (double) windowSize)));
+				cosineSum(window, windowSize, 0.44859f, 0.49364f, 0.05677f);
 				break;
 				
 			case WIND_BLACKMAN_70:
-				for (i = 0; i < windowSize; i++)
-					window[i] = (0.42323f - 0.49755f * cos(WIND_TWOPI * ((double) i / (double) windowSize)) + 0.07922f * cos(WIND_FOURPI * ((double) i / (double) windowSize)));
+				cosineSum(window, windowSize, 0.42323f, 0.49755f, 0.07922f);
 				break;
 				
 			case WIND_BLACKMAN_74:
-				for (i = 0; i < windowSize; i++)
-					window[i] = (0.402217f - 0.49703f * cos(WIND_TWOPI * ((double) i / (double) windowSize)) + 0.09892f * cos(WIND_FOURPI * ((double) i / (double) windowSize)) - 0.00188 * cos(WIND_THREEPI * ((double) i / (double) windowSize)));
+				cosineSum(window, windowSize, 0.402217f, 0.49703f, 0.09892f, 0.00188, 1.5);
 				break;
 				
 			case WIND_BLACKMAN_92:
-				for (i = 0; i < windowSize; i++)
-					window[i] = (0.35875f - 0.48829f * cos(WIND_TWOPI * ((double) i / (double) windowSize)) + 0.14128f * cos(WIND_FOURPI * ((double) i / (double) windowSize)) - 0.01168 * cos(WIND_THREEPI * ((double) i / (double) windowSize)));
+				cosineSum(window, windowSize, 0.35875f, 0.48829f, 0.14128f, 0.01168, 1.5);
 				break;
 				
 			case WIND_BLACKMAN_HARRIS:
-				for (i = 0; i < windowSize; i++)
-					window[i] = 0.35875 - (0.48829 * cos(WIND_TWOPI * ((double) i / (double) windowSize))) + (0.14128 * cos(WIND_FOURPI * ((double) i / (double) windowSize))) - (0.01168 * cos(WIND_SIXPI * ((double) i / (double) windowSize)));
+				cosineSum(window, windowSize, 0.35875, 0.48829, 0.14128, 0.01168);
 				break;
 				
 			case WIND_FLAT_TOP:
-				for (i = 0; i < windowSize; i++)
-					window[i] = 0.2810639 - (0.5208972 * cos(WIND_TWOPI * ((double) i / (double) windowSize))) + (0.1980399 * cos(WIND_FOURPI * ((double) i / (double) windowSize)));
+				cosineSum(window, windowSize, 0.2810639, 0.5208972, 0.1980399);
 				break;
 				
 			case WIND_RECT:
 				for (i = 0; i < windowSize; i++)
 					window[i] = 1.;
 				break;
+				
+			case WIND_TUKEY:
+				ratio = std::max(0.0, std::min(1.0, params.get(0, 0.5)));
+				for (i = 0; i <= (windowSize >> 1) && i < windowSize; i++)
+				{
+					val = (double) i / (double) windowSize;
+					window[i] = val < ratio * 0.5 ? 0.5 - (0.5 * cos(WIND_TWOPI * val / ratio)) : 1.0;
+				}
+				for (; i < windowSize; i++)
+					window[i] = window[windowSize - i];
+				break;
+				
+			case WIND_DPSS:
+				dpss(window, windowSize, params.get(0, 3.0));
+				break;
+				
+			case WIND_COSINE_SUM:
+				if (params.mNValues)
+					cosineSum(window, windowSize, params.mValues, params.mNValues);
+				else
+					cosineSum(window, windowSize, 0.5, 0.5);
+				break;
 		}
 		
 		if (sqrtWindow == true)
@@ -226,31 +270,903 @@ private:
 		for (i = 0, windowSqGain = 0.; i < windowSize; i++)
 			windowSqGain += window[i] * window[i];
 		windowSqGain /= (double) windowSize;
+	}
+	
+	
+	// Equivalent noise bandwidth (in bins) from the mean linear and squared gains
+	
+	static double ENBW(double windowLinGain, double windowSqGain)
+	{
+		return windowSqGain / (windowLinGain * windowLinGain);
+	}
+	
+	
+	// Gain compensation for a given gain type (as a multiplier)
+	
+	static double compensation(GainTypes compensateWindowGain, double windowLinGain, double windowSqGain)
+	{
+		if (compensateWindowGain == WIND_LIN_GAIN)
+			return 1.0 / windowLinGain;
+		if (compensateWindowGain == WIND_SQ_GAIN)
+			return 1.0 / windowSqGain;
+		if (compensateWindowGain == WIND_SQ_OVER_LIN_GAIN)
+			return windowLinGain / windowSqGain;
+		
+		return 1.0;
+	}
+	
+	
+private:
+	
+	// Cosine-sum windows: a0 - a1 * cos(x) + a2 * cos(2x) - a3 * cos(3x)... where x = 2 * pi * i / windowSize
+	
+	// cos(x) is generated by a complex rotation that is reseeded from cos() / sin() every kReseed samples
+	// Errors grow linearly between reseeds, so values stay within ~1e-14 of the exact values for any size
+	// Higher harmonics are summed as a Chebyshev series in cos(x) (by Clenshaw recurrence)
+	// The window is symmetric (window[i] = window[size - i]) so only the first half is generated
+	
+	static void cosineSum(double *window, unsigned long windowSize, const double *coefficients, unsigned long nCoefficients)
+	{
+		const unsigned long kReseed = 64;
+		
+		double rotCos, rotSin, c, s, t;
+		
+		unsigned long generateSize = (windowSize >> 1) + 1;
+		unsigned long i, j;
+		
+		if (!windowSize || !nCoefficients)
+			return;
+		
+		generateSize = generateSize > windowSize ? windowSize : generateSize;
+		rotCos = cos(WIND_TWOPI / (double) windowSize);
+		rotSin = sin(WIND_TWOPI / (double) windowSize);
+		
+		for (i = 0; i < generateSize; i += kReseed)
+		{
+			unsigned long loopSize = (generateSize - i) < kReseed ? (generateSize - i) : kReseed;
+			
+			c = cos(WIND_TWOPI * ((double) i / (double) windowSize));
+			s = sin(WIND_TWOPI * ((double) i / (double) windowSize));
+			
+			for (j = i; j < i + loopSize; j++)
+			{
+				double y1 = 0.0;
+				double y2 = 0.0;
+				
+				for (unsigned long k = nCoefficients - 1; k > 0; k--)
+				{
+					double y0 = ((k & 1) ? -coefficients[k] : coefficients[k]) + 2.0 * c * y1 - y2;
+					y2 = y1;
+					y1 = y0;
+				}
+				
+				window[j] = coefficients[0] + c * y1 - y2;
+				
+				t = c * rotCos - s * rotSin;
+				s = s * rotCos + c * rotSin;
+				c = t;
+			}
+		}
+		
+		for (i = generateSize; i < windowSize; i++)
+			window[i] = window[windowSize - i];
+	}
+	
+	// Fixed cosine-sum windows (the last term may use a non-integer harmonic, which is added directly)
+	
+	static void cosineSum(double *window, unsigned long windowSize, double a0, double a1, double a2 = 0.0, double a3 = 0.0, double a3Harmonic = 3.0)
+	{
+		double coefficients[4] = {a0, a1, a2, a3Harmonic == 3.0 ? a3 : 0.0};
+		
+		cosineSum(window, windowSize, coefficients, (a3 != 0.0 && a3Harmonic == 3.0) ? 4 : 3);
+		
+		if (a3 != 0.0 && a3Harmonic != 3.0)
+		{
+			for (unsigned long i = 0; i < windowSize; i++)
+				window[i] -= a3 * cos(a3Harmonic * WIND_TWOPI * ((double) i / (double) windowSize));
+		}
+	}
+	
+	// Discrete prolate spheroidal (Slepian) window of order zero for a given time-bandwidth product
+	
+	// The window is the principal eigenvector of the tridiagonal matrix that commutes with the concentration problem
+	// The largest eigenvalue is found by Sturm sequence bisection, and the eigenvector by inverse iteration
+	// The periodic window is the first windowSize values of a symmetric window of windowSize + 1 values
+	// Scratch memory is allocated, so this should be calculated away from the audio thread (using prepare() or async mode)
+	
+	static void dpss(double *window, unsigned long windowSize, double timeBandwidth)
+	{
+		unsigned long size = windowSize + 1;
+		unsigned long i, j;
+		
+		if (!windowSize)
+			return;
+		
+		double *diag = new double[size * 4];
+		double *offDiag = diag + size;
+		double *vector = offDiag + size;
+		double *temp = vector + size;
+		
+		double cosW = cos(WIND_TWOPI * timeBandwidth / (double) windowSize);
+		double lo = HUGE_VAL;
+		double hi = -HUGE_VAL;
+		double lambda, norm;
+		
+		// Matrix (offDiag[i] couples i - 1 and i) and Gershgorin bounds
+		
+		for (i = 0; i < size; i++)
+		{
+			double centre = ((double) size - 1.0) * 0.5 - (double) i;
+			
+			diag[i] = centre * centre * cosW;
+			offDiag[i] = i ? 0.5 * (double) i * (double) (size - i) : 0.0;
+		}
+		
+		for (i = 0; i < size; i++)
+		{
+			double radius = fabs(offDiag[i]) + (i + 1 < size ? fabs(offDiag[i + 1]) : 0.0);
+			
+			lo = std::min(lo, diag[i] - radius);
+			hi = std::max(hi, diag[i] + radius);
+		}
+		
+		// Bisect for the largest eigenvalue (hi stays an upper bound, so the shifted matrix is semi-definite)
+		
+		for (j = 0; j < 256 && (hi - lo) > 1e-15 * std::max(fabs(lo), fabs(hi)); j++)
+		{
+			double mid = 0.5 * (lo + hi);
+			
+			if (countBelow(diag, offDiag, size, mid) == size)
+				hi = mid;
+			else
+				lo = mid;
+		}
+		
+		lambda = hi;
+		
+		// Inverse iteration (solving (T - lambda) y = x by Thomas algorithm)
+		
+		for (i = 0; i < size; i++)
+			vector[i] = 1.0;
+		
+		for (j = 0; j < 3; j++)
+		{
+			double pivot = diag[0] - lambda;
+			
+			pivot = fabs(pivot) < 1e-300 ? -1e-300 : pivot;
+			temp[0] = size > 1 ? offDiag[1] / pivot : 0.0;
+			vector[0] /= pivot;
+			
+			for (i = 1; i < size; i++)
+			{
+				pivot = diag[i] - lambda - offDiag[i] * temp[i - 1];
+				pivot = fabs(pivot) < 1e-300 ? -1e-300 : pivot;
+				temp[i] = i + 1 < size ? offDiag[i + 1] / pivot : 0.0;
+				vector[i] = (vector[i] - offDiag[i] * vector[i - 1]) / pivot;
+			}
+			
+			for (i = size - 1; i > 0; i--)
+				vector[i - 1] -= temp[i - 1] * vector[i];
+			
+			for (i = 0, norm = 0.0; i < size; i++)
+				norm = std::max(norm, fabs(vector[i]));
+			
+			for (i = 0; i < size; i++)
+				vector[i] /= norm;
+		}
+		
+		// Normalise to a positive peak of one
+		
+		norm = vector[size >> 1] < 0.0 ? -1.0 : 1.0;
+		
+		for (i = 0; i < windowSize; i++)
+			window[i] = vector[i] * norm;
+		
+		delete[] diag;
+	}
+	
+	// Sturm count of eigenvalues below a value for a symmetric tridiagonal matrix
+	
+	static unsigned long countBelow(const double *diag, const double *offDiag, unsigned long size, double value)
+	{
+		unsigned long count = 0;
+		double q = 1.0;
+		
+		for (unsigned long i = 0; i < size; i++)
+		{
+			q = diag[i] - value - (i ? offDiag[i] * offDiag[i] / q : 0.0);
+			q = q == 0.0 ? -1e-300 : q;
+			
+			if (q < 0.0)
+				count++;
+		}
+		
+		return count;
+	}
+};
+
+
+// A process-wide cache of immutable window tables, keyed by (type, size, sqrt, gain type, parameters)
+// Tables are stored with the gain compensation applied, and are shared between instances by reference counting
+
+// Lookups (and releases) are lock-free and never allocate, so may be made on the audio thread
+// Tables are only calculated and inserted by prepare() (which takes a lock) and only deleted by purge() once unreferenced
+// purge() waits for any lookups in progress to finish, so that a table is never deleted while a lookup might be reading it
+// The generation changes whenever a table is inserted, so a lookup that has missed only needs repeating once it has changed
+// Asynchronous calculation for all instances shares a single worker thread (started when the first client is added)
 
+class HISSTools_Window_Cache
+{
+	
+public:
+	
+	struct Table
+	{
+		Table(WindowTypes windowType, unsigned long windowSize, bool sqrtWindow, GainTypes gainType, const HISSTools_Window_Params &params)
+		: mWindowType(windowType), mWindowSize(windowSize), mSqrtWindow(sqrtWindow), mGainType(gainType), mParams(params), mRefCount(0)
+		{
+			mWindow = new double[windowSize ? windowSize : 1];
+			
+			HISSTools_Window_Functions::calculate(mWindow, windowSize, windowType, sqrtWindow, mLinGain, mSqGain, params);
+			mENBW = HISSTools_Window_Functions::ENBW(mLinGain, mSqGain);
+			
+			double gain = HISSTools_Window_Functions::compensation(gainType, mLinGain, mSqGain);
+			
+			for (unsigned long i = 0; i < windowSize; i++)
+				mWindow[i] *= gain;
+		}
+		
+		~Table()
+		{
+			delete[] mWindow;
+		}
+		
+		bool matches(WindowTypes windowType, unsigned long windowSize, bool sqrtWindow, GainTypes gainType, const HISSTools_Window_Params &params) const
+		{
+			return mWindowType == windowType && mWindowSize == windowSize && mSqrtWindow == sqrtWindow && mGainType == gainType && mParams == params;
+		}
+		
+		// Key
+		
+		const WindowTypes mWindowType;
+		const unsigned long mWindowSize;
+		const bool mSqrtWindow;
+		const GainTypes mGainType;
+		const HISSTools_Window_Params mParams;
+		
+		// Data (the window with gain compensation, and the gains and ENBW of the uncompensated window)
+		
+		double *mWindow;
+		double mLinGain;
+		double mSqGain;
+		double mENBW;
+		
+		std::atomic<int32_t> mRefCount;
+	};
+	
+	typedef void (*Work)(void *client);
+	
+	// The cache is never destroyed, as instances may outlive it at exit
+	
+	static HISSTools_Window_Cache& get()
+	{
+		static HISSTools_Window_Cache *cache = new HISSTools_Window_Cache();
+		
+		return *cache;
+	}
+	
+	// Lock-free (returns a retained table, or NULL if the table is not in the cache)
+	
+	Table *lookup(WindowTypes windowType, unsigned long windowSize, bool sqrtWindow, GainTypes gainType, const HISSTools_Window_Params &params = HISSTools_Window_Params())
+	{
+		Table *table = NULL;
+		
+		// Reader counting and slot removal are sequentially consistent, so purge() either sees this lookup or it sees the removal
+		
+		mReaders.fetch_add(1);
+		
+		for (unsigned long i = 0, slot = hash(windowType, windowSize, sqrtWindow, gainType, params); i < kNumSlots; i++, slot = (slot + 1) & (kNumSlots - 1))
+		{
+			Table *candidate = mSlots[slot].load();
+			
+			if (candidate && candidate->matches(windowType, windowSize, sqrtWindow, gainType, params))
+			{
+				candidate->mRefCount.fetch_add(1, std::memory_order_acq_rel);
+				table = candidate;
+				break;
+			}
+		}
+		
+		mReaders.fetch_sub(1);
+		
+		return table;
+	}
+	
+	// Not realtime safe (returns a retained table, calculating and inserting it if needed, or NULL if the cache is full)
+	
+	Table *prepare(WindowTypes windowType, unsigned long windowSize, bool sqrtWindow, GainTypes gainType, const HISSTools_Window_Params &params = HISSTools_Window_Params())
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		
+		Table *table = lookup(windowType, windowSize, sqrtWindow, gainType, params);
+		
+		for (unsigned long i = 0, slot = hash(windowType, windowSize, sqrtWindow, gainType, params); !table && i < kNumSlots; i++, slot = (slot + 1) & (kNumSlots - 1))
+		{
+			if (!mSlots[slot].load(std::memory_order_acquire))
+			{
+				table = new Table(windowType, windowSize, sqrtWindow, gainType, params);
+				table->mRefCount = 1;
+				mSlots[slot].store(table, std::memory_order_release);
+				mGeneration.fetch_add(1, std::memory_order_release);
+			}
+		}
+		
+		return table;
+	}
+	
+	// Lock-free (read before a lookup, so that any table inserted after the lookup changes the value)
+	
+	unsigned long generation() const
+	{
+		return mGeneration.load(std::memory_order_acquire);
+	}
+	
+	// Lock-free (the table is kept until purged)
+	
+	static void release(Table *table)
+	{
+		if (table)
+			table->mRefCount.fetch_sub(1, std::memory_order_acq_rel);
+	}
+	
+	// Not realtime safe (the client's work is called on the shared worker after each wake)
+	
+	void addClient(Work work, void *client)
+	{
+		std::lock_guard<std::mutex> lock(mClientMutex);
+		
+		mClients.push_back(Client(work, client));
+		
+		if (!mWorker.load(std::memory_order_acquire))
+			mWorker.store(new HISSTools_WorkerThread(std::bind(&HISSTools_Window_Cache::work, this)), std::memory_order_release);
+	}
+	
+	// Not realtime safe (once this returns the client's work is not running and will not be called again)
+	
+	void removeClient(void *client)
+	{
+		std::lock_guard<std::mutex> lock(mClientMutex);
+		
+		for (std::vector<Client>::iterator it = mClients.begin(); it != mClients.end(); it++)
+		{
+			if (it->mClient == client)
+			{
+				mClients.erase(it);
+				break;
+			}
+		}
+	}
+	
+	// Lock-free (only valid once a client has been added)
+	
+	void wake()
+	{
+		mWorker.load(std::memory_order_acquire)->wake();
+	}
+	
+	// Not realtime safe (deletes all unreferenced tables)
+	
+	void purge()
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		
+		Table *removed[kNumSlots];
+		unsigned long nRemoved = 0;
+		
+		// Remove unreferenced tables from the slots, then wait for lookups that might have found them to finish
+		
+		for (unsigned long i = 0; i < kNumSlots; i++)
+		{
+			Table *table = mSlots[i].load(std::memory_order_acquire);
+			
+			if (table && !table->mRefCount.load(std::memory_order_acquire))
+			{
+				mSlots[i].store(NULL);
+				removed[nRemoved++] = table;
+			}
+		}
+		
+		while (mReaders.load())
+			std::this_thread::yield();
+		
+		// Delete tables (any table retained by a lookup in the meantime goes back into the cache)
+		
+		bool reinserted = false;
+		
+		for (unsigned long i = 0; i < nRemoved; i++)
+		{
+			if (removed[i]->mRefCount.load(std::memory_order_acquire))
+				reinserted = reinsert(removed[i]) || reinserted;
+			else
+				delete removed[i];
+		}
+		
+		// Lookups made whilst a table was out of the cache may have missed it
+		
+		if (reinserted)
+			mGeneration.fetch_add(1, std::memory_order_release);
+	}
+	
+private:
+	
+	static const unsigned long kNumSlots = 256;
+	
+	struct Client
+	{
+		Client(Work work, void *client) : mWork(work), mClient(client) {}
+		
+		Work mWork;
+		void *mClient;
+	};
+	
+	HISSTools_Window_Cache() : mReaders(0), mGeneration(0), mWorker(NULL)
+	{
+		for (unsigned long i = 0; i < kNumSlots; i++)
+			mSlots[i] = NULL;
+	}
+	
+	// Non-copyable
+	
+	HISSTools_Window_Cache(const HISSTools_Window_Cache&) = delete;
+	HISSTools_Window_Cache& operator=(const HISSTools_Window_Cache&) = delete;
+	
+	static unsigned long hash(WindowTypes windowType, unsigned long windowSize, bool sqrtWindow, GainTypes gainType, const HISSTools_Window_Params &params)
+	{
+		unsigned long key = ((((windowSize * 16) + windowType) * 2 + (sqrtWindow ? 1 : 0)) * 4 + gainType) ^ params.hash();
+		
+		return (key * 2654435761UL) & (kNumSlots - 1);
+	}
+	
+	// Worker thread (every client checks its own requests, so one wake serves all of them)
+	
+	void work()
+	{
+		std::lock_guard<std::mutex> lock(mClientMutex);
+		
+		for (std::vector<Client>::iterator it = mClients.begin(); it != mClients.end(); it++)
+			it->mWork(it->mClient);
+	}
+	
+	bool reinsert(Table *table)
+	{
+		for (unsigned long i = 0, slot = hash(table->mWindowType, table->mWindowSize, table->mSqrtWindow, table->mGainType, table->mParams); i < kNumSlots; i++, slot = (slot + 1) & (kNumSlots - 1))
+		{
+			if (!mSlots[slot].load(std::memory_order_acquire))
+			{
+				mSlots[slot].store(table, std::memory_order_release);
+				return true;
+			}
+		}
+		
+		return false;
+	}
+	
+	std::atomic<Table *> mSlots[kNumSlots];
+	std::atomic<unsigned long> mReaders;
+	std::atomic<unsigned long> mGeneration;
+	std::mutex mMutex;
+	
+	// Shared Worker
+	
+	std::vector<Client> mClients;
+	std::atomic<HISSTools_WorkerThread *> mWorker;
+	std::mutex mClientMutex;
+};
+
+
+class HISSTools_Windows
+{
+	
+public:
+	
+	HISSTools_Windows(unsigned long maxwindowSize) : mRequests(8)
+	{
+		if (maxwindowSize < 1)
+			maxwindowSize = 1;
+		
+		mWindow = new double[maxwindowSize];	
+		mScaledWindow = HISSTools_SIMD::allocate<double>(maxwindowSize);
+		
+		if (mWindow && mScaledWindow)
+			mMaxWindowSize = maxwindowSize;
+		else
+			mMaxWindowSize = 0;
+		
+		// Force calculation on the first call
+		
+		mWindowSize = -1;
+		mTable = NULL;
+		mWindowVersion = 0;
+		mScaledVersion = -1;
+		mScaledSource = NULL;
+		mAppliedLinGain = mAppliedSqGain = mAppliedENBW = 1.0;
+		mMissPending = false;
+		mMissGeneration = 0;
+		
+		// Asynchronous Calculation
+		
+		mAsync = false;
+		mPublished = NULL;
+		mFailedRequest = 0;
+		mRequestID = 0;
+		mRequestPending = false;
+	};
+	
+	
+	~HISSTools_Windows() 
+	{
+		setAsync(false);
+		HISSTools_Window_Cache::release(mTable);
+		HISSTools_SIMD::deallocate(mScaledWindow);
+		delete[] mWindow;
+	};
+	
+	
+	// Not realtime safe - make sure a window is in the shared cache (so applyWindow() will not need to calculate it)
+	
+	void prepare(WindowTypes windowType, unsigned long windowSize, bool sqrtWindow, GainTypes compensateWindowGain, const HISSTools_Window_Params &params = HISSTools_Window_Params())
+	{
+		HISSTools_Window_Cache::Table *table = HISSTools_Window_Cache::get().prepare(windowType, windowSize, sqrtWindow, compensateWindowGain, params);
+		
+		if (table)
+		{
+			HISSTools_Window_Cache::release(mTable);
+			mTable = table;
+			mWindowVersion++;
+		}
+	}
+	
+	
+	// Asynchronous mode - windows not in the cache are calculated on the cache's shared worker thread and then published to the cache
+	// Until the new window arrives the previous window of the same size keeps being applied (so parameter changes never calculate inline)
+	// Size changes cannot reuse the previous window and are calculated inline (call prepare() ahead of time to avoid this)
+	// Not threadsafe - call when not applying windows
+	
+	void setAsync(bool async)
+	{
+		Request request;
+		
+		if (mAsync)
+			HISSTools_Window_Cache::get().removeClient(this);
+		
+		mAsync = false;
+		
+		while (mRequests.pop(request));
+		HISSTools_Window_Cache::release(mPublished.exchange(NULL));
+		mRequestPending = false;
+		
+		if (async)
+		{
+			HISSTools_Window_Cache::get().addClient(&HISSTools_Windows::asyncWork, this);
+			mAsync = true;
+		}
+	}
+	
+	
+	// Parameters are only used by the parameterised window types (see HISSTools_Window_Params)
+	
+	bool applyWindow(double *in, double *out, WindowTypes windowType, unsigned long windowSize, bool sqrtWindow, double fixedGain, GainTypes compensateWindowGain, const HISSTools_Window_Params &params = HISSTools_Window_Params())
+	{
+		const double *window = getWindow(windowType, windowSize, sqrtWindow, fixedGain, compensateWindowGain, params);
+		
+		if (!window)
+			return false;
+		
+		HISSTools_SIMD::multiply(out, in, window, windowSize);
+		
+		return true;
+	}
+	
+	
+	void applyWindow(double *io, WindowTypes windowType, unsigned long windowSize, bool sqrtWindow, double fixedGain, GainTypes compensateWindowGain, const HISSTools_Window_Params &params = HISSTools_Window_Params())
+	{
+		applyWindow(io, io, windowType, windowSize, sqrtWindow, fixedGain, compensateWindowGain, params);
+	}
+	
+	
+	// Multichannel (one window applied to nChans frames, in blocks so the window is read once from memory)
+	
+	bool applyWindow(double **ins, double **outs, unsigned long nChans, WindowTypes windowType, unsigned long windowSize, bool sqrtWindow, double fixedGain, GainTypes compensateWindowGain, const HISSTools_Window_Params &params = HISSTools_Window_Params())
+	{
+		const unsigned long blockSize = 1024;
+		
+		const double *window = getWindow(windowType, windowSize, sqrtWindow, fixedGain, compensateWindowGain, params);
+		
+		if (!window)
+			return false;
+		
+		for (unsigned long i = 0; i < windowSize; i += blockSize)
+		{
+			unsigned long loopSize = (windowSize - i) < blockSize ? (windowSize - i) : blockSize;
+			
+			for (unsigned long j = 0; j < nChans; j++)
+				HISSTools_SIMD::multiply(outs[j] + i, ins[j] + i, window + i, loopSize);
+		}
+		
+		return true;
+	}
+	
+	
+	bool applyWindow(double **ios, unsigned long nChans, WindowTypes windowType, unsigned long windowSize, bool sqrtWindow, double fixedGain, GainTypes compensateWindowGain, const HISSTools_Window_Params &params = HISSTools_Window_Params())
+	{
+		return applyWindow(ios, ios, nChans, windowType, windowSize, sqrtWindow, fixedGain, compensateWindowGain, params);
+	}
+	
+	
+	// Gains (mean linear and squared) and equivalent noise bandwidth (in bins) of the last window applied (before compensation)
+	
+	double getLinGain() const	{ return mAppliedLinGain; }
+	double getSqGain() const	{ return mAppliedSqGain; }
+	double getENBW() const		{ return mAppliedENBW; }
+	
+	
+private:
+	
+	// Returns the window with all gains applied (or NULL if the size is too large)
+	
+	const double *getWindow(WindowTypes windowType, unsigned long windowSize, bool sqrtWindow, double fixedGain, GainTypes compensateWindowGain, const HISSTools_Window_Params &params)
+	{
+		const double *window = mWindow;
+		double gain = fixedGain;
+		
+		// Sanity Check
+
+		if (windowSize > mMaxWindowSize)
+			return NULL;
+		
+		// Use a shared table if one is available (looking in the cache whenever the parameters or the cache contents change)
+		
+		bool pending = false;
+		
+		if (!mTable || !mTable->matches(windowType, windowSize, sqrtWindow, compensateWindowGain, params))
+		{
+			if (mAsync)
+				pending = updateAsync(windowType, windowSize, sqrtWindow, compensateWindowGain, params);
+			else
+				setTable(lookup(windowType, windowSize, sqrtWindow, compensateWindowGain, params));
+		}
+		
+		// Whilst a new window is pending a previous table of the right size may be used
+		
+		if (mTable && (pending || mTable->matches(windowType, windowSize, sqrtWindow, compensateWindowGain, params)) && mTable->mWindowSize == windowSize)
+		{
+			window = mTable->mWindow;
+			
+			mAppliedLinGain = mTable->mLinGain;
+			mAppliedSqGain = mTable->mSqGain;
+			mAppliedENBW = mTable->mENBW;
+		}
+		else
+		{
+			// Otherwise calculate a private window (or reuse the previous one whilst a new window is pending)
+			
+			if (windowSize != mWindowSize || (!pending && (windowType != mWindowType || sqrtWindow != mSqrtWindow || params != mParams)))
+				calculateWindow(windowSize, windowType, sqrtWindow, params);
+			
+			gain *= HISSTools_Window_Functions::compensation(compensateWindowGain, mWindowLinGain, mWindowSqGain);
+			
+			mAppliedLinGain = mWindowLinGain;
+			mAppliedSqGain = mWindowSqGain;
+			mAppliedENBW = mWindowENBW;
+		}
+		
+		if (gain == 1.0)
+			return window;
+		
+		// Pre-scale by the overall gain (only when the window or gain has changed)
+		
+		if (mScaledSource != window || mScaledVersion != mWindowVersion || mScaledGain != gain || mScaledSize != windowSize)
+		{
+			for (unsigned long i = 0; i < windowSize; i++)
+				mScaledWindow[i] = window[i] * gain;
+			
+			mScaledSource = window;
+			mScaledVersion = mWindowVersion;
+			mScaledGain = gain;
+			mScaledSize = windowSize;
+		}
+		
+		return mScaledWindow;
+	}
+	
+	
+	
+	// The version only changes with the table (so the scaled window is kept when a lookup misses again)
+	
+	void setTable(HISSTools_Window_Cache::Table *table)
+	{
+		HISSTools_Window_Cache::release(mTable);
+		
+		if (table != mTable)
+			mWindowVersion++;
+		
+		mTable = table;
+	}
+	
+	
+	// Lock-free (a key that has missed is not looked up again until the cache generation changes)
+	
+	HISSTools_Window_Cache::Table *lookup(WindowTypes windowType, unsigned long windowSize, bool sqrtWindow, GainTypes gainType, const HISSTools_Window_Params &params)
+	{
+		HISSTools_Window_Cache& cache = HISSTools_Window_Cache::get();
+		
+		unsigned long generation = cache.generation();
+		
+		if (mMissPending && mMissGeneration == generation && mMiss.matches(windowType, windowSize, sqrtWindow, gainType, params))
+			return NULL;
+		
+		HISSTools_Window_Cache::Table *table = cache.lookup(windowType, windowSize, sqrtWindow, gainType, params);
+		
+		if (!table)
+		{
+			Request miss = {windowType, windowSize, sqrtWindow, gainType, params, 0};
+			
+			mMiss = miss;
+			mMissGeneration = generation;
+		}
+		
+		mMissPending = !table;
+		
+		return table;
+	}
+	
+	
+	// Audio thread (returns true if a window for these parameters is being calculated on the worker)
+	
+	bool updateAsync(WindowTypes windowType, unsigned long windowSize, bool sqrtWindow, GainTypes gainType, const HISSTools_Window_Params &params)
+	{
+		HISSTools_Window_Cache::Table *table = mPublished.exchange(NULL, std::memory_order_acq_rel);
+		
+		// Collect any newly published table, and then look in the cache directly
+		
+		if (table)
+			setTable(table);
+		
+		if (mTable && mTable->matches(windowType, windowSize, sqrtWindow, gainType, params))
+			return false;
+		
+		if ((table = lookup(windowType, windowSize, sqrtWindow, gainType, params)))
+		{
+			setTable(table);
+			return false;
+		}
+		
+		// Post a request (once per parameter change)
+		
+		if (!mRequestPending || !mRequest.matches(windowType, windowSize, sqrtWindow, gainType, params))
+		{
+			Request request = {windowType, windowSize, sqrtWindow, gainType, params, mRequestID + 1};
+			
+			if (!mRequests.push(request))
+				return false;
+			
+			mRequest = request;
+			mRequestID++;
+			mRequestPending = true;
+			HISSTools_Window_Cache::get().wake();
+		}
+		
+		// A failed request (if the cache is full) falls back to calculating inline
+		
+		return mFailedRequest.load(std::memory_order_acquire) != mRequest.mID;
+	}
+	
+	
+	// Shared worker thread (only the most recent request is calculated)
+	
+	static void asyncWork(void *client)
+	{
+		static_cast<HISSTools_Windows *>(client)->work();
+	}
+	
+	
+	void work()
+	{
+		Request request;
+		bool requested = false;
+		
+		while (mRequests.pop(request))
+			requested = true;
+		
+		if (!requested)
+			return;
+		
+		HISSTools_Window_Cache::Table *table = HISSTools_Window_Cache::get().prepare(request.mWindowType, request.mWindowSize, request.mSqrtWindow, request.mGainType, request.mParams);
+		
+		if (table)
+			HISSTools_Window_Cache::release(mPublished.exchange(table, std::memory_order_acq_rel));
+		else
+			mFailedRequest.store(request.mID, std::memory_order_release);
+	}
+	
+	
+	void calculateWindow(unsigned long windowSize, WindowTypes windowType, bool sqrtWindow, const HISSTools_Window_Params &params)
+	{
+		HISSTools_Window_Functions::calculate(mWindow, windowSize, windowType, sqrtWindow, mWindowLinGain, mWindowSqGain, params);
+		mWindowENBW = HISSTools_Window_Functions::ENBW(mWindowLinGain, mWindowSqGain);
+		
 		mWindowSize = windowSize;
 		mWindowType = windowType;
 		mSqrtWindow = sqrtWindow;
-		mWindowLinGain = windowLinGain;
-		mWindowSqGain = windowSqGain;
+		mParams = params;
+		mWindowVersion++;
 	}
 	
 	
 private:
 	
-	// Window
+	// Window (shared, or calculated privately when not in the cache)
 	
+	HISSTools_Window_Cache::Table *mTable;
 	double *mWindow;
 	
+	// Window pre-scaled by the overall gain (the version changes whenever the source window does)
+	
+	double *mScaledWindow;
+	const double *mScaledSource;
+	double mScaledGain;
+	unsigned long mScaledSize;
+	unsigned long mScaledVersion;
+	unsigned long mWindowVersion;
+	
+	// Asynchronous Calculation (requests are posted to the worker, which publishes tables by swapping a single pointer)
+	
+	struct Request
+	{
+		bool matches(WindowTypes windowType, unsigned long windowSize, bool sqrtWindow, GainTypes gainType, const HISSTools_Window_Params &params) const
+		{
+			return mWindowType == windowType && mWindowSize == windowSize && mSqrtWindow == sqrtWindow && mGainType == gainType && mParams == params;
+		}
+		
+		WindowTypes mWindowType;
+		unsigned long mWindowSize;
+		bool mSqrtWindow;
+		GainTypes mGainType;
+		HISSTools_Window_Params mParams;
+		unsigned long mID;
+	};
+	
+	bool mAsync;
+	HISSTools_SPSCQueue<Request> mRequests;
+	std::atomic<HISSTools_Window_Cache::Table *> mPublished;
+	std::atomic<unsigned long> mFailedRequest;
+	
+	Request mRequest;
+	unsigned long mRequestID;
+	bool mRequestPending;
+	
+	// Last key to miss in the cache (and the cache generation at the time)
+	
+	Request mMiss;
+	unsigned long mMissGeneration;
+	bool mMissPending;
+	
 	// Current Parameters
 	
 	unsigned long mWindowSize;
 	WindowTypes mWindowType;
 	bool mSqrtWindow;
+	HISSTools_Window_Params mParams;
 	
-	// Gain Values
+	// Gain Values (of the private window, and of the last window applied)
 	
 	double mWindowLinGain;	
 	double mWindowSqGain;	
+	double mWindowENBW;
+	
+	double mAppliedLinGain;
+	double mAppliedSqGain;
+	double mAppliedENBW;
 	
 	// Maximum Size
 	
@@ -6,6 +6,31 @@
 #include "HISSTools_Pointers.hpp"
 
 #include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+#if defined(__APPLE__)
+#include <dispatch/dispatch.h>
+#elif defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#include <windows.h>
+#undef NOMINMAX
+#else
+#include <windows.h>
+#endif
+#else
+#include <cerrno>
+#include <semaphore.h>
+#endif
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////// Lightweight Spinlock ////////////////////////////////////////////////////
@@ -162,4 +187,450 @@ public:
 	}
 };
 
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////// Triple Buffer ///////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Hands a value from any number of writer threads to a single reader thread
+// The reader is wait-free and always sees a complete value (writers are serialised with a spinlock, but never wait on the reader)
+
+template <class T>
+class HISSTools_TripleBuffer
+{
+	
+private:
+	
+	static const int32_t kIndexMask = 0x3;
+	static const int32_t kNewData = 0x4;
+	
+	// Slots (the front is owned by the reader, the back by the writers, and the middle is swapped between them)
+	
+	T mSlots[3];
+	
+	std::atomic<int32_t> mMiddle;
+	int32_t mFront;
+	int32_t mBack;
+	
+	HISSTools_SpinLock mWriteLock;
+	
+public:
+	
+	HISSTools_TripleBuffer(const T& value = T()) : mMiddle(1), mFront(0), mBack(2)
+	{
+		for (int i = 0; i < 3; i++)
+			mSlots[i] = value;
+	}
+	
+	// Non-copyable
+	
+	HISSTools_TripleBuffer(const HISSTools_TripleBuffer&) = delete;
+	HISSTools_TripleBuffer& operator=(const HISSTools_TripleBuffer&) = delete;
+	
+	void write(const T& value)
+	{
+		mWriteLock.acquire();
+		mSlots[mBack] = value;
+		mBack = mMiddle.exchange(mBack | kNewData, std::memory_order_acq_rel) & kIndexMask;
+		mWriteLock.release();
+	}
+	
+	// Returns true if the value has been written since the last read
+	
+	bool read(T& value)
+	{
+		bool newData = (mMiddle.load(std::memory_order_relaxed) & kNewData) != 0;
+		
+		if (newData)
+			mFront = mMiddle.exchange(mFront, std::memory_order_acq_rel) & kIndexMask;
+		
+		value = mSlots[mFront];
+		
+		return newData;
+	}
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////// SPSC Queue ////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// A bounded lock-free queue for a single producer thread and a single consumer thread (push and pop never block)
+
+template <class T>
+class HISSTools_SPSCQueue
+{
+	
+private:
+	
+	T *mItems;
+	unsigned long mMask;
+	
+	// Read and write counts (padded onto separate cache lines)
+	
+	std::atomic<unsigned long> mRead;
+	char mPadding[64];
+	std::atomic<unsigned long> mWrite;
+	
+public:
+	
+	HISSTools_SPSCQueue(unsigned long capacity) : mRead(0), mWrite(0)
+	{
+		unsigned long size = 1;
+		
+		while (size < capacity)
+			size <<= 1;
+		
+		mItems = new T[size];
+		mMask = size - 1;
+	}
+	
+	~HISSTools_SPSCQueue()
+	{
+		delete[] mItems;
+	}
+	
+	// Non-copyable
+	
+	HISSTools_SPSCQueue(const HISSTools_SPSCQueue&) = delete;
+	HISSTools_SPSCQueue& operator=(const HISSTools_SPSCQueue&) = delete;
+	
+	// Producer only (returns false if the queue is full)
+	
+	bool push(const T& item)
+	{
+		unsigned long write = mWrite.load(std::memory_order_relaxed);
+		
+		if (write - mRead.load(std::memory_order_acquire) > mMask)
+			return false;
+		
+		mItems[write & mMask] = item;
+		mWrite.store(write + 1, std::memory_order_release);
+		
+		return true;
+	}
+	
+	// Consumer only (returns false if the queue is empty)
+	
+	bool pop(T& item)
+	{
+		unsigned long read = mRead.load(std::memory_order_relaxed);
+		
+		if (read == mWrite.load(std::memory_order_acquire))
+			return false;
+		
+		item = mItems[read & mMask];
+		mRead.store(read + 1, std::memory_order_release);
+		
+		return true;
+	}
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////// Worker Thread ///////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// A counting semaphore using the platform primitive (signal() does not take a lock, so it is safe to call from the audio thread)
+
+class HISSTools_Semaphore
+{
+	
+private:
+	
+#if defined(__APPLE__)
+	dispatch_semaphore_t mSemaphore;
+#elif defined(_WIN32)
+	HANDLE mSemaphore;
+#else
+	sem_t mSemaphore;
+#endif
+	
+public:
+	
+	HISSTools_Semaphore()
+	{
+#if defined(__APPLE__)
+		mSemaphore = dispatch_semaphore_create(0);
+#elif defined(_WIN32)
+		mSemaphore = CreateSemaphore(NULL, 0, MAXLONG, NULL);
+#else
+		sem_init(&mSemaphore, 0, 0);
+#endif
+	}
+	
+	~HISSTools_Semaphore()
+	{
+#if defined(__APPLE__)
+		dispatch_release(mSemaphore);
+#elif defined(_WIN32)
+		CloseHandle(mSemaphore);
+#else
+		sem_destroy(&mSemaphore);
+#endif
+	}
+	
+	// Non-copyable
+	
+	HISSTools_Semaphore(const HISSTools_Semaphore&) = delete;
+	HISSTools_Semaphore& operator=(const HISSTools_Semaphore&) = delete;
+	
+	void signal()
+	{
+#if defined(__APPLE__)
+		dispatch_semaphore_signal(mSemaphore);
+#elif defined(_WIN32)
+		ReleaseSemaphore(mSemaphore, 1, NULL);
+#else
+		sem_post(&mSemaphore);
+#endif
+	}
+	
+	void wait()
+	{
+#if defined(__APPLE__)
+		dispatch_semaphore_wait(mSemaphore, DISPATCH_TIME_FOREVER);
+#elif defined(_WIN32)
+		WaitForSingleObject(mSemaphore, INFINITE);
+#else
+		while (sem_wait(&mSemaphore) == -1 && errno == EINTR);
+#endif
+	}
+};
+
+
+// A thread that runs a function each time it is woken (it sleeps on a semaphore in between, so an idle worker never wakes)
+// wake() never takes a lock, so it is safe to call from the audio thread
+
+class HISSTools_WorkerThread
+{
+	
+private:
+	
+	std::function<void()> mWork;
+	
+	std::atomic<bool> mWake;
+	std::atomic<bool> mQuit;
+	
+	HISSTools_Semaphore mSemaphore;
+	
+	std::thread mThread;
+	
+	void run()
+	{
+		while (true)
+		{
+			mSemaphore.wait();
+			
+			if (mQuit.load(std::memory_order_acquire))
+				break;
+			
+			// Clear the flag before working, so that a wake during the work is never lost (it signals again)
+			
+			mWake.exchange(false, std::memory_order_acq_rel);
+			mWork();
+		}
+	}
+	
+public:
+	
+	HISSTools_WorkerThread(std::function<void()> work)
+	: mWork(work), mWake(false), mQuit(false), mThread(&HISSTools_WorkerThread::run, this)
+	{
+	}
+	
+	~HISSTools_WorkerThread()
+	{
+		mQuit.store(true, std::memory_order_release);
+		mSemaphore.signal();
+		mThread.join();
+	}
+	
+	// Non-copyable
+	
+	HISSTools_WorkerThread(const HISSTools_WorkerThread&) = delete;
+	HISSTools_WorkerThread& operator=(const HISSTools_WorkerThread&) = delete;
+	
+	// Only the first wake since the worker last started working signals (so the semaphore count stays small)
+	
+	void wake()
+	{
+		if (!mWake.exchange(true, std::memory_order_acq_rel))
+			mSemaphore.signal();
+	}
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////// Worker Pool ////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// A fixed set of threads for running a batch of independent tasks from the audio thread (the caller also runs tasks)
+// Workers spin briefly after each batch and then park (with a timed wait as a backstop against missed wakes)
+// parallelFor() never allocates or locks - if another caller is already using the pool the tasks are all run inline
+// The claim word packs the batch generation, task count and next task, so checking the bounds and claiming is a single CAS
+
+class HISSTools_WorkerPool
+{
+	
+public:
+	
+	typedef void (*Task)(void *context, unsigned long task);
+	
+	HISSTools_WorkerPool(unsigned long nThreads)
+	: mTask(NULL), mContext(NULL), mClaim(0), mCompleted(0), mParked(0), mQuit(false)
+	{
+		nThreads = nThreads > 64 ? 64 : nThreads;
+		
+		for (unsigned long i = 0; i < nThreads; i++)
+			mThreads[i] = new std::thread(&HISSTools_WorkerPool::run, this);
+		
+		mNThreads = nThreads;
+	}
+	
+	~HISSTools_WorkerPool()
+	{
+		mQuit.store(true, std::memory_order_release);
+		mCondition.notify_all();
+		
+		for (unsigned long i = 0; i < mNThreads; i++)
+		{
+			mThreads[i]->join();
+			delete mThreads[i];
+		}
+	}
+	
+	// Non-copyable
+	
+	HISSTools_WorkerPool(const HISSTools_WorkerPool&) = delete;
+	HISSTools_WorkerPool& operator=(const HISSTools_WorkerPool&) = delete;
+	
+	unsigned long getNThreads() const	{ return mNThreads; }
+	
+	// Runs task(context, i) for i in [0, nTasks) and returns once all are complete (returns false if they were run inline)
+	// Batches of more than kMaxTasks tasks are always run inline
+	
+	bool parallelFor(Task task, void *context, unsigned long nTasks)
+	{
+		if (!mNThreads || nTasks < 2 || nTasks > kMaxTasks || !mBusyLock.attempt())
+		{
+			for (unsigned long i = 0; i < nTasks; i++)
+				task(context, i);
+			
+			return false;
+		}
+		
+		// Publish the batch (the task and context are written before the claim is released, and workers only read them once claimed)
+		// A worker still holding a claim word from the previous batch cannot claim, as its CAS fails against the new word
+		
+		uint64_t generation = (getGeneration(mClaim.load(std::memory_order_relaxed)) + 1) & kGenerationMask;
+		
+		mTask = task;
+		mContext = context;
+		mCompleted.store(0, std::memory_order_relaxed);
+		mClaim.store((generation << (kIndexBits * 2)) | ((uint64_t) nTasks << kIndexBits), std::memory_order_release);
+		
+		if (mParked.load(std::memory_order_acquire))
+			mCondition.notify_all();
+		
+		// Participate, then wait for any tasks still running on workers
+		
+		runTasks(generation);
+		
+		while (mCompleted.load(std::memory_order_acquire) != nTasks)
+			pause();
+		
+		mBusyLock.release();
+		
+		return true;
+	}
+	
+private:
+	
+	// Claim word layout (generation : count : next task)
+	
+	static const uint64_t kIndexBits = 20;
+	static const uint64_t kIndexMask = (1ULL << kIndexBits) - 1;
+	static const uint64_t kGenerationMask = (1ULL << (64 - kIndexBits * 2)) - 1;
+	static const unsigned long kMaxTasks = (unsigned long) kIndexMask;
+	
+	static uint64_t getGeneration(uint64_t claim)	{ return claim >> (kIndexBits * 2); }
+	static uint64_t getCount(uint64_t claim)		{ return (claim >> kIndexBits) & kIndexMask; }
+	static uint64_t getNext(uint64_t claim)			{ return claim & kIndexMask; }
+	
+	static void pause()
+	{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+		_mm_pause();
+#else
+		std::this_thread::yield();
+#endif
+	}
+	
+	void runTasks(uint64_t generation)
+	{
+		while (true)
+		{
+			uint64_t claim = mClaim.load(std::memory_order_acquire);
+			
+			if (getGeneration(claim) != generation || getNext(claim) >= getCount(claim))
+				return;
+			
+			// The task and context are only read once a task is claimed (the batch cannot change until it completes)
+			
+			if (mClaim.compare_exchange_weak(claim, claim + 1, std::memory_order_acq_rel))
+			{
+				mTask(mContext, (unsigned long) getNext(claim));
+				mCompleted.fetch_add(1, std::memory_order_acq_rel);
+			}
+		}
+	}
+	
+	void run()
+	{
+		uint64_t generation = getGeneration(mClaim.load(std::memory_order_acquire));
+		
+		while (!mQuit.load(std::memory_order_acquire))
+		{
+			// Spin, then park until there is a new batch
+			
+			for (int i = 0; i < 4096 && getGeneration(mClaim.load(std::memory_order_acquire)) == generation; i++)
+				pause();
+			
+			if (getGeneration(mClaim.load(std::memory_order_acquire)) == generation)
+			{
+				std::unique_lock<std::mutex> lock(mMutex);
+				
+				mParked++;
+				mCondition.wait_for(lock, std::chrono::milliseconds(1), [this, generation] { return getGeneration(mClaim.load()) != generation || mQuit.load(); });
+				mParked--;
+			}
+			
+			generation = getGeneration(mClaim.load(std::memory_order_acquire));
+			runTasks(generation);
+		}
+	}
+	
+	// Current Batch
+	
+	Task mTask;
+	void *mContext;
+	
+	std::atomic<uint64_t> mClaim;
+	char mPadding[64];
+	std::atomic<unsigned long> mCompleted;
+	
+	// Threads
+	
+	std::thread *mThreads[64];
+	unsigned long mNThreads;
+	
+	std::atomic<int> mParked;
+	std::atomic<bool> mQuit;
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	
+	HISSTools_SpinLock mBusyLock;
+};
+
 #endif	/* __HISSTOOLS_THREADSAFETY__ */